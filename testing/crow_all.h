@@ -60,28 +60,19 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             // Initialize with the default values
             if (::deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, algo, 8, Z_DEFAULT_STRATEGY) == Z_OK)
             {
-                char buffer[8192];
-
                 stream.avail_in = str.size();
                 // zlib does not take a const pointer. The data is not altered.
                 stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(str.c_str()));
 
-                int code = Z_OK;
-                do
-                {
-                    stream.avail_out = sizeof(buffer);
-                    stream.next_out = reinterpret_cast<Bytef*>(&buffer[0]);
-
-                    code = ::deflate(&stream, Z_FINISH);
-                    // Successful and non-fatal error code returned by deflate when used with Z_FINISH flush
-                    if (code == Z_OK || code == Z_STREAM_END)
-                    {
-                        std::copy(&buffer[0], &buffer[sizeof(buffer) - stream.avail_out], std::back_inserter(compressed_str));
-                    }
+                // deflateBound() is enough room for any input (wrapper included), so everything is compressed
+                // straight into the result in one call and shrunk to fit afterwards
+                compressed_str.resize(::deflateBound(&stream, str.size()));
+                stream.avail_out = compressed_str.size();
+                stream.next_out = reinterpret_cast<Bytef*>(&compressed_str[0]);
 
-                } while (code == Z_OK);
-
-                if (code != Z_STREAM_END)
+                if (::deflate(&stream, Z_FINISH) == Z_STREAM_END)
+                    compressed_str.resize(stream.total_out);
+                else
                     compressed_str.clear();
 
                 ::deflateEnd(&stream);
@@ -1005,6 +996,45 @@ namespace crow
 #define CROW_STATIC_ENDPOINT "/static/<path>"
 #endif
 
+/* #ifdef - serve static files with read() + write() even where sendfile(2) is available */
+//#define CROW_DISABLE_SENDFILE
+
+/* #define - how many bytes of a static file sendfile(2) may push before yielding to other connections */
+#ifndef CROW_SENDFILE_CHUNK_SIZE
+#define CROW_SENDFILE_CHUNK_SIZE (4 * 1024 * 1024)
+#endif
+
+#if defined(__linux__) && !defined(CROW_DISABLE_SENDFILE)
+#define CROW_HAS_SENDFILE
+#endif
+
+/* #ifdef - stat and open static files on every request instead of keeping them open in crow::open_file_cache */
+//#define CROW_DISABLE_FILE_CACHE
+
+/* #define - how many files crow::open_file_cache keeps open, 0 keeps a quarter of the RLIMIT_NOFILE soft limit */
+#ifndef CROW_FILE_CACHE_SIZE
+#define CROW_FILE_CACHE_SIZE 0
+#endif
+
+#if defined(__linux__) && !defined(CROW_DISABLE_FILE_CACHE)
+#define CROW_HAS_FILE_CACHE
+#endif
+
+/* #define - how many bytes of bodies crow::compression::response_cache keeps (compressed plus original), 0 compresses every response afresh */
+#ifndef CROW_COMPRESSION_CACHE_SIZE
+#define CROW_COMPRESSION_CACHE_SIZE (16 * 1024 * 1024)
+#endif
+
+/* #define - how many idle read buffers each thread keeps for connections to check out */
+#ifndef CROW_READ_BUFFER_POOL_SIZE
+#define CROW_READ_BUFFER_POOL_SIZE 1024
+#endif
+
+/* #define - how many closed connections' memory each worker keeps for the next ones it accepts */
+#ifndef CROW_CONNECTION_POOL_SIZE
+#define CROW_CONNECTION_POOL_SIZE 1024
+#endif
+
 // compiler flags
 
 #if defined(_MSC_VER)
@@ -1054,6 +1084,8 @@ namespace crow
     struct SocketAdaptor
     {
         using context = void;
+        static constexpr bool supports_sendfile = true; ///< Whether the kernel can write file pages straight into this socket.
+        static constexpr bool can_wait_readable = true; ///< Whether a readable raw socket means data to read (nothing buffers it in between).
         SocketAdaptor(asio::io_context& io_context, context*):
           socket_(io_context)
         {}
@@ -1117,6 +1149,10 @@ namespace crow
         template<typename F>
         void start(F f)
         {
+            // Responses are written in as few pieces as possible already, Nagle would only hold back the tail of one
+            // waiting for the client's (delayed) ACK of the previous piece
+            error_code ec;
+            socket_.set_option(tcp::no_delay(true), ec);
             f(error_code());
         }
 
@@ -1126,6 +1162,8 @@ namespace crow
     struct UnixSocketAdaptor
     {
         using context = void;
+        static constexpr bool supports_sendfile = true;
+        static constexpr bool can_wait_readable = true;
         UnixSocketAdaptor(asio::io_context& io_context, context*):
           socket_(io_context)
         {
@@ -1199,6 +1237,8 @@ namespace crow
     {
         using context = asio::ssl::context;
         using ssl_socket_t = asio::ssl::stream<tcp::socket>;
+        static constexpr bool supports_sendfile = false; // the payload has to pass through OpenSSL
+        static constexpr bool can_wait_readable = false; // OpenSSL may hold decrypted data the socket no longer shows
         SSLAdaptor(asio::io_context& io_context, context* ctx):
           ssl_socket_(new ssl_socket_t(io_context, *ctx))
         {}
@@ -1273,6 +1313,8 @@ namespace crow
         template<typename F>
         void start(F f)
         {
+            error_code ec;
+            raw_socket().set_option(tcp::no_delay(true), ec);
             ssl_socket_->async_handshake(asio::ssl::stream_base::server,
                                          [f](const error_code& ec) {
                                              f(ec);
@@ -1533,6 +1575,12 @@ namespace crow
             return acceptor_.local_endpoint();
         }
         inline static tcp::acceptor::reuse_address reuse_address_option() { return tcp::acceptor::reuse_address(true); }
+#ifdef SO_REUSEPORT
+        static constexpr bool supports_reuse_port = true; ///< Whether several sockets can listen on the same endpoint.
+        using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#else
+        static constexpr bool supports_reuse_port = false;
+#endif
     };
 
     struct UnixSocketAcceptor
@@ -1567,6 +1615,7 @@ namespace crow
             // reuse addr must be false (https://github.com/chriskohlhoff/asio/issues/622)
             return stream_protocol::acceptor::reuse_address(false);
         }
+        static constexpr bool supports_reuse_port = false;
     };
 } // namespace crow
 
@@ -4628,6 +4677,7 @@ namespace crow
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <iostream>
 
@@ -4854,7 +4904,7 @@ namespace crow
         std::vector<int64_t> int_params;
         std::vector<uint64_t> uint_params;
         std::vector<double> double_params;
-        std::vector<std::string> string_params;
+        std::vector<std::string_view> string_params; ///< Point into the URL that was routed, which outlives the handler call.
 
         void debug_print() const
         {
@@ -4873,6 +4923,14 @@ namespace crow
             std::cerr << std::endl;
         }
 
+        /// Point the string parameters found in `from` at the same offsets of `to`, once the URL was moved there.
+        void move_string_params(std::string_view from, std::string_view to)
+        {
+            for (auto& param : string_params)
+                if (param.data() >= from.data() && param.data() < from.data() + from.size())
+                    param = to.substr(param.data() - from.data(), param.size());
+        }
+
         template<typename T>
         T get(unsigned) const;
     };
@@ -4898,7 +4956,7 @@ namespace crow
     template<>
     inline std::string routing_params::get<std::string>(unsigned index) const
     {
-        return string_params[index];
+        return std::string(string_params[index]);
     }
     /// @endcond
 
@@ -5108,6 +5166,7 @@ enum http_connection_flags // This is basically 7 booleans placed into 1 integer
   CROW_XX(INVALID_CONSTANT, "invalid constant string")                                  \
   CROW_XX(INVALID_INTERNAL_STATE, "encountered unexpected internal state")              \
   CROW_XX(STRICT, "strict mode assertion failed")                                       \
+  CROW_XX(PAUSED, "parser is paused")                                                   \
   CROW_XX(UNKNOWN, "an unknown error occurred")                                         \
   CROW_XX(INVALID_TRANSFER_ENCODING, "request has invalid transfer-encoding")           \
 
@@ -6954,6 +7013,22 @@ http_body_is_final(const struct http_parser *parser) {
     return parser->state == s_message_done;
 }
 
+/* Pause or un-pause the parser; a nonzero value pauses */
+inline void
+http_parser_pause(http_parser *parser, int paused) {
+  /* Users should only be pausing/unpausing a parser that is not in an error
+   * state. In non-debug builds, there's not much that we can do about this
+   * other than ignore it.
+   */
+  if (CROW_HTTP_PARSER_ERRNO(parser) == CHPE_OK ||
+      CROW_HTTP_PARSER_ERRNO(parser) == CHPE_PAUSED) {
+    uint32_t nread = parser->nread; /* used by the CROW_SET_ERRNO macro */
+    CROW_SET_ERRNO((paused) ? CHPE_PAUSED : CHPE_OK);
+  } else {
+    assert(0 && "Attempting to pause parser in error state");
+  }
+}
+
 /* Change the maximum header size provided at compile time. */
 inline void
 http_parser_set_max_header_size(uint32_t size) {
@@ -7006,10 +7081,10 @@ http_parser_set_max_header_size(uint32_t size) {
 #include <asio/basic_waitable_timer.hpp>
 #endif
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <functional>
-#include <map>
-#include <vector>
 
 
 namespace crow
@@ -7023,72 +7098,112 @@ namespace crow
     namespace detail
     {
 
-        /// A class for scheduling functions to be called after a specific
-        /// amount of ticks. Ther tick length can  be handed over in constructor, 
-        /// the default tick length is equal to 1 second.
+        /// Runs tasks after a timeout, on the thread of an io_context.
+        ///
+        /// Tasks are scheduled with an \ref entry that lives in the object the task is about (a connection's deadline), so
+        /// scheduling, rescheduling and cancelling only link or unlink it and never allocate. Entries are kept in a hierarchical
+        /// timing wheel with millisecond resolution: 4 levels of 64 slots, each level 64 times as coarse as the one below, reach
+        /// about 4.6 hours ahead, later entries wait in the last slot. An entry moves down a level when its slot comes up and runs
+        /// from the lowest level, so every operation is O(1) no matter how many entries are scheduled. The asio timer is only armed
+        /// for the next slot that has something to do, an idle wheel doesn't wake up at all.
+        ///
+        /// Timeouts are given in ticks, the tick length can be handed over in the constructor and defaults to 1 second.
         class task_timer
         {
         public:
             using task_type = std::function<void()>;
-            using identifier_type = size_t;
+
+            /// A task that can be scheduled on a task_timer, meant to be a member of the object the task belongs to.
+            ///
+            /// The task is given once, at construction. Destroying an entry that is scheduled cancels it, and destroying the
+            /// timer unschedules all its entries.
+            class entry
+            {
+            public:
+                explicit entry(task_type task):
+                  task_(std::move(task))
+                {}
+
+                ~entry()
+                {
+                    if (timer_)
+                        timer_->cancel(*this);
+                }
+
+                entry(const entry&) = delete;
+                entry& operator=(const entry&) = delete;
+
+                /// Whether the entry is waiting to run.
+                bool scheduled() const
+                {
+                    return timer_ != nullptr;
+                }
+
+            private:
+                friend class task_timer;
+
+                task_type task_;
+                task_timer* timer_ = nullptr;
+                entry* prev_ = nullptr;
+                entry* next_ = nullptr;
+                uint64_t due_ = 0;  ///< In milliseconds since the timer was created.
+                uint8_t level_ = 0; ///< Level of the wheel or expired_level.
+                uint8_t slot_ = 0;
+            };
 
         private:
             using clock_type = std::chrono::steady_clock;
             using time_type = clock_type::time_point;
+
+            static constexpr unsigned slot_bits = 6;
+            static constexpr unsigned slot_count = 1 << slot_bits;
+            static constexpr unsigned level_count = 4;
+            static constexpr uint8_t expired_level = level_count; ///< Entries taken off the wheel to be run right now.
+
         public:
             task_timer(asio::io_context& io_context,
                        const std::chrono::milliseconds tick_length =
                             std::chrono::seconds(1)) :
               io_context_(io_context), timer_(io_context_),
-              tick_length_ms_(tick_length)
+              tick_length_ms_(tick_length), start_(clock_type::now())
+            {}
+
+            ~task_timer()
             {
-                timer_.expires_after(tick_length_ms_);
-                timer_.async_wait(
-                  std::bind(&task_timer::tick_handler, this,
-                  std::placeholders::_1));
+                timer_.cancel();
+                for (auto& level : slots_)
+                    for (entry* head : level)
+                        detach(head);
+                detach(expired_);
             }
 
-            ~task_timer() { timer_.cancel(); }
-
-            /// Cancel the scheduling of the given task 
-            ///
-            /// \param identifier_type task identifier of the task to cancel.
-            void cancel(identifier_type id)
+            /// Cancel the given entry, nothing happens if it isn't scheduled.
+            void cancel(entry& e)
             {
-                tasks_.erase(id);
-                CROW_LOG_DEBUG << "task_timer task cancelled: " << this << ' ' << id;
+                if (!e.timer_)
+                    return;
+                unlink(e);
+                e.timer_ = nullptr;
             }
 
-            /// Schedule the given task to be executed after the default amount
-            /// of ticks.
-
-            ///
-            /// \return identifier_type Used to cancel the thread.
-            /// It is not bound to this task_timer instance and in some cases
-            /// could lead to undefined behavior if used with other task_timer
-            /// objects or after the task has been successfully executed.
-            identifier_type schedule(const task_type& task)
+            /// Schedule the given entry to run after the default amount of ticks, replacing its previous schedule.
+            void schedule(entry& e)
             {
-                return schedule(task, get_default_timeout());
+                schedule(e, get_default_timeout());
             }
 
-            /// Schedule the given task to be executed after the given time.
-
-            ///
-            /// \param timeout The amount of ticks to wait before execution.
-            ///
-            /// \return identifier_type Used to cancel the thread.
-            /// It is not bound to this task_timer instance and in some cases
-            /// could lead to undefined behavior if used with other task_timer
-            /// objects or after the task has been successfully executed.
-            identifier_type schedule(const task_type& task, uint8_t timeout)
+            /// Schedule the given entry to run after the given amount of ticks, replacing its previous schedule.
+            void schedule(entry& e, uint8_t timeout)
             {
-                tasks_.insert({++highest_id_,
-                               {clock_type::now() + (timeout * tick_length_ms_),
-                                task}});
-                CROW_LOG_DEBUG << "task_timer scheduled: " << this << ' ' <<
-                                  highest_id_;
-                return highest_id_;
+                cancel(e);
+                // An idle wheel hasn't been advanced, catch up so the entry lands on the level it belongs to
+                if (!occupied_[0] && !occupied_[1] && !occupied_[2] && !occupied_[3])
+                    now_ = std::max(now_, elapsed_ms());
+                // At least one millisecond away, the current one may have been run already
+                e.due_ = std::max(elapsed_ms() + timeout * static_cast<uint64_t>(tick_length_ms_.count()), now_ + 1);
+                e.timer_ = this;
+                link(e);
+                arm();
             }
 
             /// Set the default timeout for this task_timer instance.
@@ -7113,52 +7228,183 @@ namespace crow
             }
 
         private:
-            void process_tasks()
+            uint64_t elapsed_ms() const
             {
-                time_type current_time = clock_type::now();
-                std::vector<identifier_type> finished_tasks;
+                return std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - start_).count();
+            }
+
+            static unsigned lowest_bit(uint64_t bits)
+            {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_ctzll(bits);
+#else
+                unsigned bit = 0;
+                while (!(bits & 1))
+                {
+                    bits >>= 1;
+                    bit++;
+                }
+                return bit;
+#endif
+            }
 
-                for (const auto& task : tasks_)
+            /// Put an entry in the slot of the lowest level its due time falls into, relative to now_.
+            void link(entry& e)
+            {
+                unsigned level = 0;
+                uint64_t slot = 0;
+                for (; level < level_count; level++)
                 {
-                    if (task.second.first < current_time)
+                    unsigned shift = level * slot_bits;
+                    uint64_t ahead = (e.due_ >> shift) - (now_ >> shift);
+                    if (ahead < slot_count)
+                    {
+                        slot = (e.due_ >> shift) & (slot_count - 1);
+                        break;
+                    }
+                    if (level == level_count - 1)
                     {
-                        (task.second.second)();
-                        finished_tasks.push_back(task.first);
-                        CROW_LOG_DEBUG << "task_timer called: " << this <<
-                                          ' ' << task.first;
+                        // Beyond the wheel, wait in the slot that comes up last and be put back from there
+                        slot = ((now_ >> shift) + slot_count - 1) & (slot_count - 1);
+                        break;
                     }
                 }
 
-                for (const auto& task : finished_tasks)
-                    tasks_.erase(task);
+                e.level_ = static_cast<uint8_t>(level);
+                e.slot_ = static_cast<uint8_t>(slot);
+                e.prev_ = nullptr;
+                e.next_ = slots_[level][slot];
+                if (e.next_)
+                    e.next_->prev_ = &e;
+                slots_[level][slot] = &e;
+                occupied_[level] |= uint64_t(1) << slot;
+            }
+
+            void unlink(entry& e)
+            {
+                entry*& head = e.level_ == expired_level ? expired_ : slots_[e.level_][e.slot_];
+                if (e.prev_)
+                    e.prev_->next_ = e.next_;
+                else
+                    head = e.next_;
+                if (e.next_)
+                    e.next_->prev_ = e.prev_;
+                if (!head && e.level_ != expired_level)
+                    occupied_[e.level_] &= ~(uint64_t(1) << e.slot_);
+                e.prev_ = e.next_ = nullptr;
+            }
+
+            /// Take a whole slot's list off the wheel.
+            entry* take(unsigned level, uint64_t slot)
+            {
+                entry* list = slots_[level][slot];
+                slots_[level][slot] = nullptr;
+                occupied_[level] &= ~(uint64_t(1) << slot);
+                return list;
+            }
 
-                // If no task is currently scheduled, reset the issued ids back
-                // to 0.
-                if (tasks_.empty()) highest_id_ = 0;
+            static void detach(entry* list)
+            {
+                for (entry* e = list; e; e = e->next_)
+                    e->timer_ = nullptr;
             }
 
-            void tick_handler(const error_code& ec)
+            /// The next millisecond anything needs to happen at (an entry to run or a slot to move down), 0 if there is nothing.
+            uint64_t next_event() const
             {
-                if (ec) return;
+                uint64_t next = 0;
+                for (unsigned level = 0; level < level_count; level++)
+                {
+                    if (!occupied_[level])
+                        continue;
+                    unsigned shift = level * slot_bits;
+                    uint64_t current = now_ >> shift;
+                    // Slots after the current one, in the order they come up
+                    unsigned rotate = (current + 1) & (slot_count - 1);
+                    uint64_t upcoming = rotate ? (occupied_[level] >> rotate) | (occupied_[level] << (slot_count - rotate)) : occupied_[level];
+                    uint64_t at = (current + 1 + lowest_bit(upcoming)) << shift;
+                    if (!next || at < next)
+                        next = at;
+                }
+                return next;
+            }
+
+            /// Run everything due up to the given millisecond.
+            void advance(uint64_t until)
+            {
+                while (true)
+                {
+                    uint64_t next = next_event();
+                    if (!next || next > until)
+                        break;
+                    now_ = next;
 
-                process_tasks();
+                    // Slots of the coarser levels that start now move down, highest first
+                    for (unsigned level = level_count - 1; level > 0; level--)
+                    {
+                        unsigned shift = level * slot_bits;
+                        if (now_ & ((uint64_t(1) << shift) - 1))
+                            continue;
+                        entry* list = take(level, (now_ >> shift) & (slot_count - 1));
+                        while (list)
+                        {
+                            entry* e = list;
+                            list = list->next_;
+                            link(*e);
+                        }
+                    }
+
+                    // Run the slot of this millisecond. Its entries wait in a list of their own, a task may cancel any of them
+                    expired_ = take(0, now_ & (slot_count - 1));
+                    for (entry* e = expired_; e; e = e->next_)
+                        e->level_ = expired_level;
+                    while (entry* e = expired_)
+                    {
+                        unlink(*e);
+                        e->timer_ = nullptr;
+                        e->task_();
+                    }
+                }
+                now_ = std::max(now_, until);
+            }
 
-                timer_.expires_after(tick_length_ms_);
+            /// Make sure the asio timer goes off for the next event.
+            void arm()
+            {
+                uint64_t next = next_event();
+                if (!next || (armed_ && armed_at_ <= next))
+                    return;
+                armed_ = true;
+                armed_at_ = next;
+                timer_.expires_at(start_ + std::chrono::milliseconds(next));
                 timer_.async_wait(
-                  std::bind(&task_timer::tick_handler, this, std::placeholders::_1));
+                  std::bind(&task_timer::tick_handler, this,
+                  std::placeholders::_1));
+            }
+
+            void tick_handler(const error_code& ec)
+            {
+                // Cancelled, the timer was re-armed for an earlier event
+                if (ec) return;
+
+                armed_ = false;
+                advance(elapsed_ms());
+                arm();
             }
 
         private:
             asio::io_context& io_context_;
             asio::basic_waitable_timer<clock_type> timer_;
-            std::map<identifier_type, std::pair<time_type, task_type>> tasks_;
-
-            // A continuously increasing number to be issued to threads to
-            // identify them. If no tasks are scheduled, it will be reset to 0.
-            identifier_type highest_id_{0};
             std::chrono::milliseconds tick_length_ms_;
             uint8_t default_timeout_{5};
 
+            time_type start_;
+            uint64_t now_ = 0; ///< Milliseconds since start_ the wheel has been advanced to.
+            entry* slots_[level_count][slot_count] = {};
+            uint64_t occupied_[level_count] = {}; ///< A bit per non-empty slot.
+            entry* expired_ = nullptr;
+            bool armed_ = false;
+            uint64_t armed_at_ = 0;
         };
     } // namespace detail
 } // namespace crow
@@ -7173,6 +7419,11 @@ namespace crow
 #include <asio.hpp>
 #endif
 
+#include <array>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 
 namespace crow // NOTE: Already documented in "crow/app.h"
 {
@@ -7180,6 +7431,74 @@ namespace crow // NOTE: Already documented in "crow/app.h"
     namespace asio = boost::asio;
 #endif
 
+    /// The headers of a request as views, in a flat table.
+    ///
+    /// A request has a dozen headers or so, comparing the names one after another beats hashing them and needs no
+    /// allocation: the first 16 headers are kept inside the table, only further ones go to the heap.
+    class header_view_table
+    {
+    public:
+        using value_type = std::pair<std::string_view, std::string_view>;
+
+        void add(std::string_view name, std::string_view value)
+        {
+            if (size_ < inline_.size())
+                inline_[size_] = {name, value};
+            else
+                overflow_.emplace_back(name, value);
+            size_++;
+        }
+
+        /// The value of the first header with the given name (case-insensitive), empty if there is none.
+        std::string_view get(std::string_view name) const
+        {
+            for (size_t i = 0; i < size_; i++)
+            {
+                const value_type& header = at(i);
+                if (utility::string_equals(header.first, name))
+                    return header.second;
+            }
+            return {};
+        }
+
+        size_t count(std::string_view name) const
+        {
+            size_t found = 0;
+            for (size_t i = 0; i < size_; i++)
+            {
+                if (utility::string_equals(at(i).first, name))
+                    found++;
+            }
+            return found;
+        }
+
+        const value_type& at(size_t i) const
+        {
+            return i < inline_.size() ? inline_[i] : overflow_[i - inline_.size()];
+        }
+
+        value_type& at(size_t i)
+        {
+            return i < inline_.size() ? inline_[i] : overflow_[i - inline_.size()];
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+
+        void clear()
+        {
+            size_ = 0;
+            overflow_.clear();
+        }
+
+    private:
+        std::array<value_type, 16> inline_;
+        std::vector<value_type> overflow_;
+        size_t size_ = 0;
+    };
+
     /// Find and return the value associated with the key. (returns an empty string if nothing is found)
     template<typename T>
     inline const std::string& get_header_value(const T& headers, const std::string& key)
@@ -7207,6 +7526,20 @@ namespace crow // NOTE: Already documented in "crow/app.h"
           close_connection, ///< Whether or not the server should shut down the TCP connection once a response is sent.
           upgrade;          ///< Whether or noth the server should change the HTTP connection to a different connection.
 
+        /// The parts of the request that point into the connection's read buffer instead of being copied.
+        ///
+        /// Only set when the app parses requests into views (\ref crow::Crow::use_request_views), `raw_url`, `url`,
+        /// `url_params` and `headers` are left empty then. The views are valid until the response is complete, \ref owned()
+        /// returns a copy with them in those members for a handler that needs strings or keeps the request longer.
+        struct
+        {
+            std::string_view raw_url; ///< The full URL containing the `?` and URL parameters.
+            std::string_view url;     ///< The endpoint without any parameters.
+            std::string_view query;   ///< Everything after the `?`, without it.
+            header_view_table headers;
+        } views;
+        bool has_views = false; ///< Whether the request was parsed into \ref views and hasn't been owned since.
+
         void* middleware_context{};
         void* middleware_container{};
         asio::io_context* io_context{};
@@ -7226,11 +7559,62 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             headers.emplace(std::move(key), std::move(value));
         }
 
+        /// Find the value of a header. (returns an empty string if nothing is found)
+        ///
+        /// Reads `headers`, use \ref get_header_view() or \ref owned() for a request parsed into views.
         const std::string& get_header_value(const std::string& key) const
         {
             return crow::get_header_value(headers, key);
         }
 
+        /// Find the value of a header without copying it, whether the request was parsed into views or not.
+        std::string_view get_header_view(std::string_view key) const
+        {
+            if (has_views)
+                return views.headers.get(key);
+            auto it = headers.find(std::string(key));
+            return it != headers.end() ? std::string_view(it->second) : std::string_view();
+        }
+
+        /// How many headers with that name the request has, whether it was parsed into views or not.
+        size_t header_count(std::string_view key) const
+        {
+            return has_views ? views.headers.count(key) : headers.count(std::string(key));
+        }
+
+        /// The endpoint without any parameters, whether the request was parsed into views or not.
+        std::string_view url_view() const
+        {
+            return has_views ? views.url : std::string_view(url);
+        }
+
+        /// Copy the \ref views into `raw_url`, `url`, `url_params` and `headers`, so the request no longer depends on the
+        /// connection's read buffer. This is where a request parsed into views allocates, nothing happens for any other one.
+        /// Handlers get a const request, they use \ref owned() instead.
+        void own()
+        {
+            if (!has_views)
+                return;
+            raw_url.assign(views.raw_url.data(), views.raw_url.size());
+            url.assign(views.url.data(), views.url.size());
+            url_params = query_string(raw_url);
+            for (size_t i = 0; i < views.headers.size(); i++)
+            {
+                const auto& header = views.headers.at(i);
+                headers.emplace(std::string(header.first), std::string(header.second));
+            }
+            views = {};
+            has_views = false;
+        }
+
+        /// A copy of the request that owns all its parts, for a handler that needs strings or keeps the request longer.
+        request owned() const
+        {
+            request copy(*this);
+            copy.own();
+            return copy;
+        }
+
         bool check_version(unsigned char major, unsigned char minor) const
         {
             return http_ver_major == major && http_ver_minor == minor;
@@ -7263,8 +7647,10 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <algorithm>
+#include <forward_list>
 
 
 namespace crow
@@ -7276,8 +7662,10 @@ namespace crow
     template<typename Handler>
     struct HTTPParser : public http_parser
     {
-        static int on_message_begin(http_parser*)
+        static int on_message_begin(http_parser* self_)
         {
+            HTTPParser* self = static_cast<HTTPParser*>(self_);
+            self->message_begun_ = true;
             return 0;
         }
         static int on_method(http_parser* self_)
@@ -7290,9 +7678,21 @@ namespace crow
         static int on_url(http_parser* self_, const char* at, size_t length)
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
-            self->req.raw_url.insert(self->req.raw_url.end(), at, at + length);
-            self->req.url_params = query_string(self->req.raw_url);
-            self->req.url = self->req.raw_url.substr(0, self->qs_point != 0 ? self->qs_point : std::string::npos);
+            if (self->use_views_)
+            {
+                std::string_view& raw_url = self->req.views.raw_url;
+                self->append(raw_url, at, length);
+                size_t qs = raw_url.find('?');
+                self->req.views.url = raw_url.substr(0, qs);
+                self->req.views.query = qs != std::string_view::npos ? raw_url.substr(qs + 1) : std::string_view();
+                self->req.has_views = true;
+            }
+            else
+            {
+                self->req.raw_url.insert(self->req.raw_url.end(), at, at + length);
+                self->req.url_params = query_string(self->req.raw_url);
+                self->req.url = self->req.raw_url.substr(0, self->qs_point != 0 ? self->qs_point : std::string::npos);
+            }
 
             self->process_url();
 
@@ -7301,6 +7701,19 @@ namespace crow
         static int on_header_field(http_parser* self_, const char* at, size_t length)
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
+            if (self->use_views_)
+            {
+                if (self->header_building_state == 0)
+                {
+                    if (!self->field_view_.empty())
+                        self->req.views.headers.add(self->field_view_, self->value_view_);
+                    self->field_view_ = {};
+                    self->value_view_ = {};
+                    self->header_building_state = 1;
+                }
+                self->append(self->field_view_, at, length);
+                return 0;
+            }
             switch (self->header_building_state)
             {
                 case 0:
@@ -7320,6 +7733,12 @@ namespace crow
         static int on_header_value(http_parser* self_, const char* at, size_t length)
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
+            if (self->use_views_)
+            {
+                self->header_building_state = 0;
+                self->append(self->value_view_, at, length);
+                return 0;
+            }
             switch (self->header_building_state)
             {
                 case 0:
@@ -7335,7 +7754,14 @@ namespace crow
         static int on_headers_complete(http_parser* self_)
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
-            if (!self->header_field.empty())
+            if (self->use_views_)
+            {
+                if (!self->field_view_.empty())
+                    self->req.views.headers.add(self->field_view_, self->value_view_);
+                self->field_view_ = {};
+                self->value_view_ = {};
+            }
+            else if (!self->header_field.empty())
             {
                 self->req.headers.emplace(std::move(self->header_field), std::move(self->header_value));
             }
@@ -7385,6 +7811,13 @@ namespace crow
             };
 
             int nparsed = http_parser_execute(this, &settings_, buffer, length);
+            if (http_errno == CHPE_PAUSED)
+            {
+                // Whatever follows the completed message stays in the caller's buffer until resume()
+                pending_ = buffer + nparsed;
+                pending_length_ = length - nparsed;
+                return true;
+            }
             if (http_errno != CHPE_OK)
             {
                 return false;
@@ -7397,17 +7830,97 @@ namespace crow
             return feed(nullptr, 0);
         }
 
+        /// Stop parsing once the current message is complete (e.g. while its response is still being written).
+        void pause()
+        {
+            if (http_errno == CHPE_OK)
+                http_parser_pause(this, 1);
+        }
+
+        /// Continue parsing the bytes that were left over when the parser got paused.
+        bool resume()
+        {
+            if (http_errno != CHPE_PAUSED)
+                return true;
+
+            http_parser_pause(this, 0);
+            const char* rest = pending_;
+            int rest_length = pending_length_;
+            pending_ = nullptr;
+            pending_length_ = 0;
+            return rest_length == 0 || feed(rest, rest_length);
+        }
+
         void clear()
         {
             req = crow::request();
             header_field.clear();
             header_value.clear();
+            field_view_ = {};
+            value_view_ = {};
+            joined_.clear();
             header_building_state = 0;
             qs_point = 0;
             message_complete = false;
+            message_begun_ = false;
             state = CROW_NEW_MESSAGE();
         }
 
+        /// Parse requests into \ref request::views that point into the buffers given to feed(), instead of copying them.
+        ///
+        /// The caller has to keep the bytes of a message where they were fed until the message is cleared, or hand them
+        /// over with own_views() before reusing that memory.
+        void use_views(bool enabled)
+        {
+            use_views_ = enabled;
+        }
+
+        /// Whether a message has started but isn't complete yet, its bytes are still needed then.
+        bool in_message() const
+        {
+            return message_begun_ && !message_complete;
+        }
+
+        /// Copy whatever the views of the current message point to in [begin, end) into storage of the parser's own.
+        void own_views(const char* begin, const char* end)
+        {
+            auto own = [&](std::string_view& view) {
+                if (!view.empty() && view.data() >= begin && view.data() < end)
+                    view = joined_.emplace_front(view);
+            };
+            std::string_view& raw_url = req.views.raw_url;
+            if (!raw_url.empty() && raw_url.data() >= begin && raw_url.data() < end)
+            {
+                // url and query are parts of raw_url and move with it
+                size_t query_offset = req.views.query.data() - raw_url.data();
+                own(raw_url);
+                req.views.url = raw_url.substr(0, req.views.url.size());
+                req.views.query = req.views.query.empty() ? std::string_view() : raw_url.substr(query_offset);
+            }
+            for (size_t i = 0; i < req.views.headers.size(); i++)
+            {
+                own(req.views.headers.at(i).first);
+                own(req.views.headers.at(i).second);
+            }
+            own(field_view_);
+            own(value_view_);
+        }
+
+        /// Extend a view by the next piece of it, which only needs a copy when the piece doesn't follow it in memory.
+        void append(std::string_view& view, const char* at, size_t length)
+        {
+            if (view.empty())
+                view = std::string_view(at, length);
+            else if (view.data() + view.size() == at)
+                view = std::string_view(view.data(), view.size() + length);
+            else
+            {
+                std::string& joined = joined_.emplace_front(view);
+                joined.append(at, length);
+                view = joined;
+            }
+        }
+
         inline void process_url()
         {
             handler_->handle_url();
@@ -7450,8 +7963,15 @@ namespace crow
     private:
         int header_building_state = 0;
         bool message_complete = false;
+        bool message_begun_ = false;
         std::string header_field;
         std::string header_value;
+        bool use_views_ = false;
+        std::string_view field_view_;
+        std::string_view value_view_;
+        std::forward_list<std::string> joined_; ///< Pieces of views that had to be copied, nodes never move.
+        const char* pending_ = nullptr;
+        int pending_length_ = 0;
 
         Handler* handler_; ///< This is currently an HTTP connection object (\ref crow.Connection).
     };
@@ -8418,6 +8938,20 @@ namespace crow
         /// Multipart map (key is the name parameter).
         using mp_map = std::unordered_multimap<std::string, part, ci_hash, ci_key_eq>;
 
+        /// The headers of a request as a map, also when it was parsed into views and `req.headers` is empty.
+        inline ci_map request_headers(const request& req)
+        {
+            if (!req.has_views)
+                return req.headers;
+            ci_map headers;
+            for (size_t i = 0; i < req.views.headers.size(); i++)
+            {
+                const auto& header = req.views.headers.at(i);
+                headers.emplace(std::string(header.first), std::string(header.second));
+            }
+            return headers;
+        }
+
         /// The parsed multipart request/response
         struct message : public returnable
         {
@@ -8491,7 +9025,7 @@ namespace crow
             /// Create a multipart message from a request data
             explicit message(const request& req):
               returnable("multipart/form-data; boundary=CROW-BOUNDARY"),
-              headers(req.headers),
+              headers(request_headers(req)),
               boundary(get_boundary(get_header_value("Content-Type")))
             {
                 if (!boundary.empty())
@@ -8805,10 +9339,15 @@ namespace crow
             }
 
             /// Create a multipart message from a request data
+            ///
+            /// A request parsed into views has no header map, the message then keeps a copy of the headers that `headers` refers to.
             explicit message_view(const request& req):
               headers(req.headers),
-              boundary(get_boundary(get_header_value("Content-Type")))
+              owned_headers_(req.has_views ? std::make_shared<const ci_map>(request_headers(req)) : nullptr)
             {
+                if (owned_headers_)
+                    headers = std::cref(*owned_headers_);
+                boundary = std::string(get_boundary(get_header_value("Content-Type")));
                 parse_body(req.body);
             }
 
@@ -8930,6 +9469,8 @@ namespace crow
                     return string.substr(1, string.length() - 2);
                 return string;
             }
+
+            std::shared_ptr<const ci_map> owned_headers_; ///< Shared by copies, so their `headers` stay valid.
         };
     } // namespace multipart
 } // namespace crow
@@ -8950,19 +9491,354 @@ namespace crow
 #endif
 
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace crow
 {
-    template<typename Adaptor, typename Handler, typename... Middlewares>
-    class Connection;
-
-    namespace websocket
+    /// An open, read-only descriptor of a static file together with its stat result.
+    struct open_file
     {
-        template<typename Adaptor, typename Handler>
-        class Connection;
-    }
+        int fd = -1;
+        struct stat statbuf;
 
-    class Router;
+        open_file() = default;
+        open_file(const open_file&) = delete;
+        open_file& operator=(const open_file&) = delete;
+        ~open_file()
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    };
+
+    /// Open descriptors and stat results of files, shared by every connection on every io_context.
+    ///
+    /// A hit costs a hash lookup instead of a path walk, a stat() and an open() per request. The directory of every cached file is
+    /// watched with inotify, and an entry is dropped as soon as its file is written to, replaced, moved or deleted. Beyond
+    /// CROW_FILE_CACHE_SIZE entries (by default a quarter of the open file limit, leaving the rest to sockets) the least recently
+    /// used ones go. Paths are keys after collapsing repeated slashes and `.` components; `..` is left alone, since resolving it
+    /// without the file system could name another file. The descriptors are shared, so they must only be read with explicit
+    /// offsets (sendfile, splice, pread); a response holding an entry keeps its file open even after it was dropped.
+    class open_file_cache
+    {
+    public:
+        static open_file_cache& instance()
+        {
+            static open_file_cache cache;
+            return cache;
+        }
+
+        /// The file open and stat'ed, or nullptr if it can't be opened. Only regular files are cached.
+        std::shared_ptr<const open_file> get(const std::string& requested_path)
+        {
+            std::string path = normalize(requested_path);
+            int wd;
+            uint64_t generation;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = entries_.find(path);
+                if (it != entries_.end())
+                {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    return it->second->file;
+                }
+                wd = watch_directory(path);
+                pending_open& pending = opening_[path];
+                pending.openers++;
+                generation = pending.generation;
+            }
+
+            auto file = std::make_shared<open_file>();
+            file->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            bool opened = file->fd >= 0 && fstat(file->fd, &file->statbuf) == 0;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto pending = opening_.find(path);
+            // The file changed while it was being opened, it may be stale already
+            bool changed = pending->second.generation != generation;
+            if (--pending->second.openers == 0)
+                opening_.erase(pending);
+            if (!opened || !S_ISREG(file->statbuf.st_mode) || wd < 0 || changed || entries_.count(path))
+            {
+                release_watch_locked(wd);
+                return opened ? file : nullptr;
+            }
+            lru_.push_front(entry{path, wd, file});
+            entries_.emplace(path, lru_.begin());
+            while (entries_.size() > capacity_)
+                remove(entries_.find(lru_.back().path));
+            return file;
+        }
+
+        open_file_cache(const open_file_cache&) = delete;
+        open_file_cache& operator=(const open_file_cache&) = delete;
+
+        ~open_file_cache()
+        {
+            if (watcher_.joinable())
+            {
+                char stop = 0;
+                if (::write(wake_fds_[1], &stop, 1) == 1)
+                    watcher_.join();
+                else
+                    watcher_.detach();
+            }
+            for (int fd : {inotify_fd_, wake_fds_[0], wake_fds_[1]})
+            {
+                if (fd >= 0)
+                    ::close(fd);
+            }
+        }
+
+    private:
+        struct entry
+        {
+            std::string path;
+            int wd; ///< Of the directory the file is in.
+            std::shared_ptr<const open_file> file;
+        };
+
+        struct watch
+        {
+            int wd;
+            std::size_t users;
+        };
+
+        /// A path get() is opening without the lock, the generation is bumped by every event about it meanwhile.
+        struct pending_open
+        {
+            std::size_t openers = 0;
+            uint64_t generation = 0;
+        };
+
+        open_file_cache():
+          capacity_(CROW_FILE_CACHE_SIZE > 0 ? CROW_FILE_CACHE_SIZE : default_capacity())
+        {
+            inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (inotify_fd_ >= 0 && ::pipe2(wake_fds_, O_CLOEXEC) == 0)
+                watcher_ = std::thread([this] {
+                    watch_events();
+                });
+        }
+
+        static std::size_t default_capacity()
+        {
+            struct rlimit limit;
+            if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY)
+                return 256;
+            return std::max<std::size_t>(limit.rlim_cur / 4, 16);
+        }
+
+        /// Collapse repeated slashes and `.` components, so that spellings of one path share an entry.
+        static std::string normalize(const std::string& path)
+        {
+            std::string normalized;
+            normalized.reserve(path.size());
+            std::size_t start = 0;
+            if (!path.empty() && path[0] == '/')
+                normalized = "/";
+            while (start < path.size())
+            {
+                std::size_t end = path.find('/', start);
+                if (end == std::string::npos)
+                    end = path.size();
+                if (end > start && !(end - start == 1 && path[start] == '.'))
+                {
+                    if (!normalized.empty() && normalized.back() != '/')
+                        normalized += '/';
+                    normalized.append(path, start, end - start);
+                }
+                start = end + 1;
+            }
+            return normalized.empty() ? "." : normalized;
+        }
+
+        /// Watch the directory the path is in, the watch descriptor or -1 if it can't be watched (the file is then not cached).
+        int watch_directory(const std::string& path)
+        {
+            if (!watcher_.joinable())
+                return -1;
+            std::string dir = directory_of(path);
+
+            auto it = dirs_.find(dir);
+            if (it != dirs_.end())
+            {
+                it->second.users++;
+                return it->second.wd;
+            }
+            int wd = inotify_add_watch(inotify_fd_, dir.c_str(),
+                                       IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                         IN_DELETE_SELF | IN_MOVE_SELF);
+            if (wd < 0)
+                return -1;
+            dirs_.emplace(dir, watch{wd, 1});
+            wds_[wd] = dir;
+            return wd;
+        }
+
+        static std::string directory_of(const std::string& path)
+        {
+            std::size_t slash = path.find_last_of('/');
+            return slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        }
+
+        /// Drop a user of a watch. Users of a watch that was already forgotten have nothing left to release.
+        void release_watch_locked(int wd)
+        {
+            auto dir = wds_.find(wd);
+            if (dir == wds_.end())
+                return;
+            auto it = dirs_.find(dir->second);
+            if (--it->second.users > 0)
+                return;
+            forget_watch_locked(dir);
+        }
+
+        /// Remove a watch, the next file opened in its directory adds a new one.
+        void forget_watch_locked(std::unordered_map<int, std::string>::iterator dir)
+        {
+            inotify_rm_watch(inotify_fd_, dir->first);
+            dirs_.erase(dir->second);
+            wds_.erase(dir);
+        }
+
+        void remove(std::unordered_map<std::string, std::list<entry>::iterator>::iterator it)
+        {
+            int wd = it->second->wd;
+            lru_.erase(it->second);
+            entries_.erase(it);
+            release_watch_locked(wd);
+        }
+
+        /// Drop the entries an inotify event is about, a file in the directory or the directory itself. Files of the directory
+        /// being opened right now aren't cached either, the rest of the cache is left alone. When the event queue overflowed,
+        /// events were lost and everything goes.
+        void invalidate(const struct inotify_event& event)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (event.mask & IN_Q_OVERFLOW)
+            {
+                for (auto& pending : opening_)
+                    pending.second.generation++;
+                while (!entries_.empty())
+                    remove(entries_.begin());
+                return;
+            }
+            auto dir = wds_.find(event.wd);
+            if (dir == wds_.end())
+                return;
+
+            if (event.len > 0)
+            {
+                std::string path = (dir->second == "." ? std::string() : dir->second == "/" ? "/" : dir->second + "/") + event.name;
+                auto pending = opening_.find(path);
+                if (pending != opening_.end())
+                    pending->second.generation++;
+                auto it = entries_.find(path);
+                if (it != entries_.end())
+                    remove(it);
+                return;
+            }
+            // The directory itself changed or went away, take everything in it along
+            std::string removed = dir->second;
+            int wd = dir->first;
+            for (auto& pending : opening_)
+            {
+                if (directory_of(pending.first) == removed)
+                    pending.second.generation++;
+            }
+            for (auto it = entries_.begin(); it != entries_.end();)
+            {
+                auto current = it++;
+                if (current->second->wd == wd)
+                    remove(current);
+            }
+            // A deleted directory's watch is dead (IN_IGNORED follows), a moved one's would report paths under the old name.
+            // Files being opened there still count as users, they find nothing to release.
+            dir = wds_.find(wd);
+            if (dir != wds_.end() && (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)))
+                forget_watch_locked(dir);
+        }
+
+        void watch_events()
+        {
+            alignas(struct inotify_event) char buffer[4096];
+            pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+            while (true)
+            {
+                if (::poll(fds, 2, -1) < 0 && errno != EINTR)
+                    return;
+                if (fds[1].revents)
+                    return;
+                ssize_t length;
+                while ((length = ::read(inotify_fd_, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char* p = buffer; p < buffer + length;)
+                    {
+                        auto event = reinterpret_cast<struct inotify_event*>(p);
+                        invalidate(*event);
+                        p += sizeof(struct inotify_event) + event->len;
+                    }
+                }
+            }
+        }
+
+        std::mutex mutex_;
+        std::list<entry> lru_; ///< Most recently used first.
+        std::unordered_map<std::string, std::list<entry>::iterator> entries_;
+        std::unordered_map<std::string, watch> dirs_;
+        std::unordered_map<int, std::string> wds_;
+        std::unordered_map<std::string, pending_open> opening_;
+        std::size_t capacity_;
+
+        int inotify_fd_ = -1;
+        int wake_fds_[2] = {-1, -1};
+        std::thread watcher_;
+    };
+} // namespace crow
+#endif
+
+
+
+namespace crow
+{
+    template<typename Adaptor, typename Handler, typename... Middlewares>
+    class Connection;
+
+    namespace websocket
+    {
+        template<typename Adaptor, typename Handler>
+        class Connection;
+    }
+
+    class Router;
+
+    /// A response body that is produced a chunk at a time while it is being sent.
+
+    ///
+    /// The connection asks for the next chunk only once the previous one has been written to the socket,
+    /// so a slow client slows the producer down and a connection never holds more than one chunk of the body.
+    struct body_source
+    {
+        /// Receives a chunk of the body. An empty chunk ends the body, `ok == false` aborts it (and closes the connection).
+        /// `owner` keeps the chunk's memory alive until it has been written.
+        using chunk_handler = std::function<void(bool ok, const char* data, std::size_t size, std::shared_ptr<const void> owner)>;
+
+        virtual ~body_source() = default;
+
+        /// Produce the next chunk and pass it to `handler`, either right away or later from the connection's io_context.
+        virtual void next(chunk_handler handler) = 0;
+    };
 
     /// HTTP response
     struct response
@@ -9108,6 +9984,9 @@ namespace crow
             headers = std::move(r.headers);
             completed_ = r.completed_;
             file_info = std::move(r.file_info);
+            sent_handler_ = std::move(r.sent_handler_);
+            body_views_ = std::move(r.body_views_);
+            body_source_ = std::move(r.body_source_);
             return *this;
         }
 
@@ -9124,6 +10003,9 @@ namespace crow
             headers.clear();
             completed_ = false;
             file_info = static_file_info{};
+            sent_handler_ = nullptr;
+            body_views_.clear();
+            body_source_.reset();
         }
 
         /// Return a "Temporary Redirect" response.
@@ -9177,15 +10059,23 @@ namespace crow
             if (!completed_)
             {
                 completed_ = true;
-                if (skip_body)
+                if (skip_body && !is_static_type())
                 {
-                    set_header("Content-Length", std::to_string(body.size()));
+                    // A streamed body already announced its length (or chunked encoding) in the headers
+                    if (!body_source_)
+                        set_header("Content-Length", std::to_string(body_size()));
                     body = "";
+                    body_views_.clear();
+                    body_source_.reset();
                     manual_length_header = true;
                 }
                 if (complete_request_handler_)
                 {
-                    complete_request_handler_();
+                    // Run a copy: the connection drops the original in prepare_buffers(),
+                    // and when the response is ended asynchronously that handler holds
+                    // the last reference to the connection (and so to this response)
+                    auto handler = complete_request_handler_;
+                    handler();
                     manual_length_header = false;
                     skip_body = false;
                 }
@@ -9205,12 +10095,90 @@ namespace crow
             return is_alive_helper_ && is_alive_helper_();
         }
 
+        /// Send memory owned by someone else (a cache entry, a mapped file, ...) as the body, without copying it into `body`.
+
+        ///
+        /// `owner` is held until the response has been written to the socket, so the memory must stay valid for as long as it lives.
+        void set_body_view(const char* data, std::size_t size, std::shared_ptr<const void> owner)
+        {
+            body.clear();
+            body_views_.clear();
+            add_body_view(data, size, std::move(owner));
+        }
+
+        /// Append another piece of borrowed memory to the body, see set_body_view().
+
+        ///
+        /// The body is the pieces one after the other, written together with the headers in a single gather write.
+        void add_body_view(const char* data, std::size_t size, std::shared_ptr<const void> owner)
+        {
+            body.clear();
+            if (size > 0)
+                body_views_.push_back({data, size, std::move(owner)});
+        }
+
+        /// Check whether the body is borrowed memory set with set_body_view() / add_body_view().
+        bool has_body_view() const
+        {
+            return !body_views_.empty();
+        }
+
+        /// Stream the body from `source` instead of building it in memory.
+
+        ///
+        /// With a known `length` the body is sent with a Content-Length, otherwise with chunked transfer encoding
+        /// (or, for HTTP/1.0 clients, by closing the connection once it is done).
+        void set_body_source(std::shared_ptr<body_source> source, int64_t length = -1)
+        {
+            body.clear();
+            body_views_.clear();
+            body_source_ = std::move(source);
+            if (length >= 0)
+                set_header("Content-Length", std::to_string(length));
+            else
+                set_header("Transfer-Encoding", "chunked");
+        }
+
+        /// Check whether the body is streamed from a body_source.
+        bool has_body_source() const
+        {
+            return body_source_ != nullptr;
+        }
+
+        /// The size of the body, whether it is owned in `body` or borrowed.
+        std::size_t body_size() const
+        {
+            if (!has_body_view())
+                return body.size();
+            std::size_t size = 0;
+            for (auto& view : body_views_)
+                size += view.size;
+            return size;
+        }
+
+        /// Call a function once the response has been handed to the socket (or failed to be).
+
+        ///
+        /// The function receives the number of body bytes that were actually written,
+        /// which makes it possible to time a response end to end instead of only until end() is called.
+        void on_sent(std::function<void(std::size_t)> handler)
+        {
+            sent_handler_ = std::move(handler);
+        }
+
         /// Check whether the response has a static file defined.
         bool is_static_type()
         {
             return file_info.path.size();
         }
 
+        /// How the contents of a static file get from the page cache into the socket.
+        enum class file_transfer
+        {
+            sendfile, ///< sendfile(2) where the platform and adaptor allow it, read() + write() otherwise.
+            splice,   ///< splice(2) from the file into a pipe and from the pipe into the socket (Linux only, same fallback).
+        };
+
         /// This constains metadata (coming from the `stat` command) related to any static files associated with this response.
 
         ///
@@ -9220,6 +10188,22 @@ namespace crow
             std::string path = "";
             struct stat statbuf;
             int statResult;
+#ifdef CROW_HAS_FILE_CACHE
+            std::shared_ptr<const open_file> file; ///< Open descriptor shared through open_file_cache.
+#endif
+            file_transfer transfer = file_transfer::sendfile;
+            uint64_t offset = 0; ///< First byte of the file to send.
+            uint64_t length = 0; ///< Number of bytes to send, the whole file unless set_static_file_extent() was used.
+
+            /// One part of a `multipart/byteranges` body.
+            struct part
+            {
+                std::string header; ///< Boundary and part headers preceding the extent.
+                uint64_t offset;
+                uint64_t length;
+            };
+            std::vector<part> parts;    ///< Set instead of offset / length when several ranges were requested.
+            std::string multipart_end; ///< Closing boundary following the last part.
         };
 
         /// Return a static file as the response body, the content_type may be specified explicitly.
@@ -9229,19 +10213,118 @@ namespace crow
             set_static_file_info_unsafe(path, content_type);
         }
 
+        /// Choose the kernel path used to send the static file set with set_static_file_info().
+        void set_static_file_transfer(file_transfer transfer)
+        {
+            file_info.transfer = transfer;
+        }
+
+        /// Only send `length` bytes of the static file starting at `offset`, e.g. one segment out of a larger media file.
+
+        ///
+        /// Must be called after set_static_file_info(), the extent is clamped to the size of the file.
+        void set_static_file_extent(uint64_t offset, uint64_t length)
+        {
+            if (!is_static_type())
+                return;
+            uint64_t size = file_info.statbuf.st_size;
+            file_info.offset = CROW_MIN(offset, size);
+            file_info.length = CROW_MIN(length, size - file_info.offset);
+            set_header("Content-Length", std::to_string(file_info.length));
+        }
+
+        /// Only send the parts of the static file asked for in an HTTP `Range` header (RFC 7233).
+
+        ///
+        /// A single satisfiable range turns the response into a 206 with a `Content-Range`, several ranges into a 206
+        /// with a `multipart/byteranges` body and no satisfiable range into a 416. A header that can't be parsed is
+        /// ignored and the whole file is sent. Ranges are relative to the extent set with set_static_file_extent(), if any.
+        /// An `If-Range` that doesn't match the file's ETag or Last-Modified means the client's copy is stale: the range is
+        /// ignored as well, so a resumed download starts over instead of splicing in parts of a changed file.
+        void set_static_file_range(std::string_view range_header, std::string_view if_range = {})
+        {
+            if (!is_static_type() || code != 200)
+                return;
+            if (!if_range.empty() && !matches_validator(if_range))
+                return;
+
+            std::vector<std::pair<uint64_t, uint64_t>> ranges;
+            const uint64_t total = file_info.length;
+            if (!parse_byte_ranges(range_header, total, ranges))
+                return;
+
+            if (ranges.empty())
+            {
+                code = 416;
+                file_info = static_file_info{};
+                headers.erase("Content-Length");
+                headers.erase("Content-Type");
+                set_header("Content-Range", "bytes */" + std::to_string(total));
+                return;
+            }
+
+            code = 206;
+            if (ranges.size() == 1)
+            {
+                file_info.offset += ranges[0].first;
+                file_info.length = ranges[0].second - ranges[0].first + 1;
+                set_header("Content-Range", "bytes " + std::to_string(ranges[0].first) + '-' + std::to_string(ranges[0].second) + '/' + std::to_string(total));
+                set_header("Content-Length", std::to_string(file_info.length));
+                return;
+            }
+
+            static const char hex[] = "0123456789abcdef";
+            thread_local std::mt19937_64 generator{std::random_device{}()};
+            uint64_t random = generator();
+            std::string boundary = "CROW_BYTERANGES_";
+            for (int i = 0; i < 16; i++, random >>= 4)
+                boundary += hex[random & 0xf];
+
+            std::string part_type = get_header_value("Content-Type");
+            uint64_t content_length = 0;
+            for (auto& range : ranges)
+            {
+                static_file_info::part part;
+                part.header = "\r\n--" + boundary + "\r\n";
+                if (!part_type.empty())
+                    part.header += "Content-Type: " + part_type + "\r\n";
+                part.header += "Content-Range: bytes " + std::to_string(range.first) + '-' + std::to_string(range.second) + '/' + std::to_string(total) + "\r\n\r\n";
+                part.offset = file_info.offset + range.first;
+                part.length = range.second - range.first + 1;
+                content_length += part.header.size() + part.length;
+                file_info.parts.push_back(std::move(part));
+            }
+            file_info.multipart_end = "\r\n--" + boundary + "--\r\n";
+            content_length += file_info.multipart_end.size();
+
+            set_header("Content-Type", "multipart/byteranges; boundary=" + boundary);
+            set_header("Content-Length", std::to_string(content_length));
+        }
+
         /// Return a static file as the response body without sanitizing the path (use set_static_file_info instead),
         /// the content_type may be specified explicitly.
         void set_static_file_info_unsafe(std::string path, std::string content_type = "")
         {
             file_info.path = path;
+#ifdef CROW_HAS_FILE_CACHE
+            file_info.file = open_file_cache::instance().get(file_info.path);
+            file_info.statResult = file_info.file ? 0 : -1;
+            if (file_info.file)
+                file_info.statbuf = file_info.file->statbuf;
+#else
             file_info.statResult = stat(file_info.path.c_str(), &file_info.statbuf);
+#endif
 #ifdef CROW_ENABLE_COMPRESSION
             compressed = false;
 #endif
             if (file_info.statResult == 0 && S_ISREG(file_info.statbuf.st_mode))
             {
                 code = 200;
+                file_info.offset = 0;
+                file_info.length = file_info.statbuf.st_size;
                 this->add_header("Content-Length", std::to_string(file_info.statbuf.st_size));
+                this->add_header("Accept-Ranges", "bytes");
+                set_validators();
 
                 if (content_type.empty())
                 {
@@ -9262,58 +10345,256 @@ namespace crow
             {
                 code = 404;
                 file_info.path.clear();
+#ifdef CROW_HAS_FILE_CACHE
+                file_info.file.reset();
+#endif
             }
         }
 
-    private:
-        void write_header_into_buffer(std::vector<asio::const_buffer>& buffers, std::string& content_length_buffer, bool add_keep_alive, const std::string& server_name)
-        {
-            // TODO(EDev): HTTP version in status codes should be dynamic
-            // Keep in sync with common.h/status
-            static std::unordered_map<int, std::string> statusCodes = {
-              {status::CONTINUE, "HTTP/1.1 100 Continue\r\n"},
-              {status::SWITCHING_PROTOCOLS, "HTTP/1.1 101 Switching Protocols\r\n"},
+        /// Send a precompressed copy of the static file instead, `<path>.br` or `<path>.gz` (in that order of preference).
 
-              {status::OK, "HTTP/1.1 200 OK\r\n"},
-              {status::CREATED, "HTTP/1.1 201 Created\r\n"},
-              {status::ACCEPTED, "HTTP/1.1 202 Accepted\r\n"},
-              {status::NON_AUTHORITATIVE_INFORMATION, "HTTP/1.1 203 Non-Authoritative Information\r\n"},
-              {status::NO_CONTENT, "HTTP/1.1 204 No Content\r\n"},
-              {status::RESET_CONTENT, "HTTP/1.1 205 Reset Content\r\n"},
-              {status::PARTIAL_CONTENT, "HTTP/1.1 206 Partial Content\r\n"},
+        ///
+        /// A copy is only used if the client accepts its encoding and it isn't older than the file. The Content-Type stays
+        /// the one of the file. Call before the range is applied. Returns whether the response was switched to a copy.
+        bool use_precompressed_file(std::string_view accept_encoding)
+        {
+            if (!is_static_type() || file_info.statResult != 0 || accept_encoding.empty())
+                return false;
 
-              {status::MULTIPLE_CHOICES, "HTTP/1.1 300 Multiple Choices\r\n"},
-              {status::MOVED_PERMANENTLY, "HTTP/1.1 301 Moved Permanently\r\n"},
-              {status::FOUND, "HTTP/1.1 302 Found\r\n"},
-              {status::SEE_OTHER, "HTTP/1.1 303 See Other\r\n"},
-              {status::NOT_MODIFIED, "HTTP/1.1 304 Not Modified\r\n"},
-              {status::TEMPORARY_REDIRECT, "HTTP/1.1 307 Temporary Redirect\r\n"},
-              {status::PERMANENT_REDIRECT, "HTTP/1.1 308 Permanent Redirect\r\n"},
+            static const std::pair<const char*, const char*> encodings[] = {{"br", ".br"}, {"gzip", ".gz"}};
+            for (auto& encoding : encodings)
+            {
+                if (!accepts_encoding(accept_encoding, encoding.first))
+                    continue;
 
-              {status::BAD_REQUEST, "HTTP/1.1 400 Bad Request\r\n"},
-              {status::UNAUTHORIZED, "HTTP/1.1 401 Unauthorized\r\n"},
-              {status::FORBIDDEN, "HTTP/1.1 403 Forbidden\r\n"},
-              {status::NOT_FOUND, "HTTP/1.1 404 Not Found\r\n"},
-              {status::METHOD_NOT_ALLOWED, "HTTP/1.1 405 Method Not Allowed\r\n"},
-              {status::NOT_ACCEPTABLE, "HTTP/1.1 406 Not Acceptable\r\n"},
-              {status::PROXY_AUTHENTICATION_REQUIRED, "HTTP/1.1 407 Proxy Authentication Required\r\n"},
-              {status::CONFLICT, "HTTP/1.1 409 Conflict\r\n"},
-              {status::GONE, "HTTP/1.1 410 Gone\r\n"},
-              {status::PAYLOAD_TOO_LARGE, "HTTP/1.1 413 Payload Too Large\r\n"},
-              {status::UNSUPPORTED_MEDIA_TYPE, "HTTP/1.1 415 Unsupported Media Type\r\n"},
-              {status::RANGE_NOT_SATISFIABLE, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
-              {status::EXPECTATION_FAILED, "HTTP/1.1 417 Expectation Failed\r\n"},
-              {status::PRECONDITION_REQUIRED, "HTTP/1.1 428 Precondition Required\r\n"},
-              {status::TOO_MANY_REQUESTS, "HTTP/1.1 429 Too Many Requests\r\n"},
-              {status::UNAVAILABLE_FOR_LEGAL_REASONS, "HTTP/1.1 451 Unavailable For Legal Reasons\r\n"},
+                static_file_info copy;
+                copy.path = file_info.path + encoding.second;
+#ifdef CROW_HAS_FILE_CACHE
+                copy.file = open_file_cache::instance().get(copy.path);
+                copy.statResult = copy.file ? 0 : -1;
+                if (copy.file)
+                    copy.statbuf = copy.file->statbuf;
+#else
+                copy.statResult = stat(copy.path.c_str(), &copy.statbuf);
+#endif
+                if (copy.statResult != 0 || !S_ISREG(copy.statbuf.st_mode) || copy.statbuf.st_mtime < file_info.statbuf.st_mtime)
+                    continue;
 
-              {status::INTERNAL_SERVER_ERROR, "HTTP/1.1 500 Internal Server Error\r\n"},
-              {status::NOT_IMPLEMENTED, "HTTP/1.1 501 Not Implemented\r\n"},
-              {status::BAD_GATEWAY, "HTTP/1.1 502 Bad Gateway\r\n"},
-              {status::SERVICE_UNAVAILABLE, "HTTP/1.1 503 Service Unavailable\r\n"},
-              {status::GATEWAY_TIMEOUT, "HTTP/1.1 504 Gateway Timeout\r\n"},
-              {status::VARIANT_ALSO_NEGOTIATES, "HTTP/1.1 506 Variant Also Negotiates\r\n"},
-            };
+                copy.transfer = file_info.transfer;
+                copy.offset = 0;
+                copy.length = copy.statbuf.st_size;
+                file_info = std::move(copy);
+                set_header("Content-Length", std::to_string(file_info.length));
+                set_header("Content-Encoding", encoding.first);
+                set_header("Vary", "Accept-Encoding");
+                set_validators();
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        /// Describe the static file with an ETag (size and modification time, like most servers) and a Last-Modified.
+        void set_validators()
+        {
+            const struct stat& statbuf = file_info.statbuf;
+            std::ostringstream etag;
+            etag << std::hex << '"' << statbuf.st_mtime;
+#ifdef __linux__
+            etag << '.' << statbuf.st_mtim.tv_nsec;
+#endif
+            etag << '-' << statbuf.st_size << '"';
+            set_header("ETag", etag.str());
+
+            tm modified;
+            time_t mtime = statbuf.st_mtime;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+            gmtime_s(&modified, &mtime);
+#else
+            gmtime_r(&mtime, &modified);
+#endif
+            char date[64];
+            std::size_t length = strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &modified);
+            set_header("Last-Modified", std::string(date, length));
+        }
+
+        /// Whether an If-Range names the file as it is now: its ETag, compared strongly (a weak one never matches), or
+        /// exactly its Last-Modified date.
+        bool matches_validator(std::string_view if_range)
+        {
+            while (!if_range.empty() && (if_range.back() == ' ' || if_range.back() == '\t'))
+                if_range.remove_suffix(1);
+            if (if_range.substr(0, 2) == "W/")
+                return false;
+            if (if_range.front() == '"')
+                return if_range == get_header_value("ETag");
+            return if_range == get_header_value("Last-Modified");
+        }
+
+        /// Whether an Accept-Encoding header lists `coding` without q=0.
+        static bool accepts_encoding(std::string_view header, const char* coding)
+        {
+            std::size_t length = strlen(coding);
+            std::size_t pos = 0;
+            while (pos < header.size())
+            {
+                std::size_t end = header.find(',', pos);
+                if (end == std::string::npos)
+                    end = header.size();
+                std::string_view item(header.data() + pos, end - pos);
+                pos = end + 1;
+
+                std::size_t first = item.find_first_not_of(" \t");
+                if (first == std::string_view::npos)
+                    continue;
+                item.remove_prefix(first);
+                std::size_t params = item.find(';');
+                std::string_view name = item.substr(0, params);
+                while (!name.empty() && (name.back() == ' ' || name.back() == '\t'))
+                    name.remove_suffix(1);
+                if (name.size() != length || !utility::string_equals(name, coding))
+                    continue;
+                if (params == std::string_view::npos)
+                    return true;
+
+                // "q=0", "q=0.0", ... turn the coding off
+                std::string_view rest = item.substr(params + 1);
+                std::size_t q = rest.find("q=");
+                if (q == std::string_view::npos)
+                    return true;
+                for (char c : rest.substr(q + 2))
+                {
+                    if (c >= '1' && c <= '9')
+                        return true;
+                    if (c != '0' && c != '.')
+                        break;
+                }
+                return false;
+            }
+            return false;
+        }
+
+        /// Parse a `bytes=` range set into inclusive (first, last) pairs, dropping the unsatisfiable ones.
+
+        ///
+        /// Returns false if the header is malformed (or asks for an unreasonable amount of ranges) and should be ignored.
+        static bool parse_byte_ranges(std::string_view header, uint64_t total, std::vector<std::pair<uint64_t, uint64_t>>& ranges)
+        {
+            static constexpr std::size_t max_ranges = 32;
+
+            std::size_t pos = header.find_first_not_of(" \t");
+            if (pos == std::string::npos || header.size() - pos < 6 || !utility::string_equals(header.substr(pos, 6), "bytes="))
+                return false;
+            pos += 6;
+
+            auto parse_number = [&](uint64_t& value) {
+                std::size_t start = pos;
+                value = 0;
+                while (pos < header.size() && header[pos] >= '0' && header[pos] <= '9')
+                {
+                    uint64_t digit = header[pos++] - '0';
+                    if (value > (UINT64_MAX - digit) / 10)
+                        return false;
+                    value = value * 10 + digit;
+                }
+                return pos != start;
+            };
+            auto skip_spaces = [&] {
+                while (pos < header.size() && (header[pos] == ' ' || header[pos] == '\t'))
+                    pos++;
+            };
+
+            std::size_t specs = 0;
+            while (pos < header.size())
+            {
+                skip_spaces();
+                if (pos < header.size() && header[pos] == ',')
+                {
+                    pos++;
+                    continue;
+                }
+                if (pos == header.size())
+                    break;
+                if (++specs > max_ranges)
+                    return false;
+
+                uint64_t first = 0, last = 0;
+                if (header[pos] == '-')
+                {
+                    // suffix range: the last N bytes
+                    pos++;
+                    uint64_t suffix;
+                    if (!parse_number(suffix))
+                        return false;
+                    if (suffix > 0 && total > 0)
+                        ranges.emplace_back(total > suffix ? total - suffix : 0, total - 1);
+                }
+                else
+                {
+                    if (!parse_number(first) || pos == header.size() || header[pos++] != '-')
+                        return false;
+                    bool open_ended = !parse_number(last);
+                    if (!open_ended && last < first)
+                        return false;
+                    if (first < total)
+                        ranges.emplace_back(first, open_ended ? total - 1 : CROW_MIN(last, total - 1));
+                }
+
+                skip_spaces();
+                if (pos < header.size() && header[pos++] != ',')
+                    return false;
+            }
+            return specs > 0;
+        }
+
+        void write_header_into_buffer(std::vector<asio::const_buffer>& buffers, std::string& content_length_buffer, bool add_keep_alive, const std::string& server_name)
+        {
+            // TODO(EDev): HTTP version in status codes should be dynamic
+            // Keep in sync with common.h/status
+            static std::unordered_map<int, std::string> statusCodes = {
+              {status::CONTINUE, "HTTP/1.1 100 Continue\r\n"},
+              {status::SWITCHING_PROTOCOLS, "HTTP/1.1 101 Switching Protocols\r\n"},
+
+              {status::OK, "HTTP/1.1 200 OK\r\n"},
+              {status::CREATED, "HTTP/1.1 201 Created\r\n"},
+              {status::ACCEPTED, "HTTP/1.1 202 Accepted\r\n"},
+              {status::NON_AUTHORITATIVE_INFORMATION, "HTTP/1.1 203 Non-Authoritative Information\r\n"},
+              {status::NO_CONTENT, "HTTP/1.1 204 No Content\r\n"},
+              {status::RESET_CONTENT, "HTTP/1.1 205 Reset Content\r\n"},
+              {status::PARTIAL_CONTENT, "HTTP/1.1 206 Partial Content\r\n"},
+
+              {status::MULTIPLE_CHOICES, "HTTP/1.1 300 Multiple Choices\r\n"},
+              {status::MOVED_PERMANENTLY, "HTTP/1.1 301 Moved Permanently\r\n"},
+              {status::FOUND, "HTTP/1.1 302 Found\r\n"},
+              {status::SEE_OTHER, "HTTP/1.1 303 See Other\r\n"},
+              {status::NOT_MODIFIED, "HTTP/1.1 304 Not Modified\r\n"},
+              {status::TEMPORARY_REDIRECT, "HTTP/1.1 307 Temporary Redirect\r\n"},
+              {status::PERMANENT_REDIRECT, "HTTP/1.1 308 Permanent Redirect\r\n"},
+
+              {status::BAD_REQUEST, "HTTP/1.1 400 Bad Request\r\n"},
+              {status::UNAUTHORIZED, "HTTP/1.1 401 Unauthorized\r\n"},
+              {status::FORBIDDEN, "HTTP/1.1 403 Forbidden\r\n"},
+              {status::NOT_FOUND, "HTTP/1.1 404 Not Found\r\n"},
+              {status::METHOD_NOT_ALLOWED, "HTTP/1.1 405 Method Not Allowed\r\n"},
+              {status::NOT_ACCEPTABLE, "HTTP/1.1 406 Not Acceptable\r\n"},
+              {status::PROXY_AUTHENTICATION_REQUIRED, "HTTP/1.1 407 Proxy Authentication Required\r\n"},
+              {status::CONFLICT, "HTTP/1.1 409 Conflict\r\n"},
+              {status::GONE, "HTTP/1.1 410 Gone\r\n"},
+              {status::PAYLOAD_TOO_LARGE, "HTTP/1.1 413 Payload Too Large\r\n"},
+              {status::UNSUPPORTED_MEDIA_TYPE, "HTTP/1.1 415 Unsupported Media Type\r\n"},
+              {status::RANGE_NOT_SATISFIABLE, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+              {status::EXPECTATION_FAILED, "HTTP/1.1 417 Expectation Failed\r\n"},
+              {status::PRECONDITION_REQUIRED, "HTTP/1.1 428 Precondition Required\r\n"},
+              {status::TOO_MANY_REQUESTS, "HTTP/1.1 429 Too Many Requests\r\n"},
+              {status::UNAVAILABLE_FOR_LEGAL_REASONS, "HTTP/1.1 451 Unavailable For Legal Reasons\r\n"},
+
+              {status::INTERNAL_SERVER_ERROR, "HTTP/1.1 500 Internal Server Error\r\n"},
+              {status::NOT_IMPLEMENTED, "HTTP/1.1 501 Not Implemented\r\n"},
+              {status::BAD_GATEWAY, "HTTP/1.1 502 Bad Gateway\r\n"},
+              {status::SERVICE_UNAVAILABLE, "HTTP/1.1 503 Service Unavailable\r\n"},
+              {status::GATEWAY_TIMEOUT, "HTTP/1.1 504 Gateway Timeout\r\n"},
+              {status::VARIANT_ALSO_NEGOTIATES, "HTTP/1.1 506 Variant Also Negotiates\r\n"},
+            };
 
             static const std::string seperator = ": ";
 
@@ -9331,7 +10612,8 @@ namespace crow
             auto& status = statusCodes.find(code)->second;
             buffers.emplace_back(status.data(), status.size());
 
-            if (code >= 400 && body.empty())
+            // A response to a HEAD request has no body, not even this one
+            if (code >= 400 && !skip_body && body.empty() && !has_body_view() && !has_body_source())
                 body = statusCodes[code].substr(9);
 
             for (auto& kv : headers)
@@ -9342,9 +10624,9 @@ namespace crow
                 buffers.emplace_back(crlf.data(), crlf.size());
             }
 
-            if (!manual_length_header && !headers.count("content-length"))
+            if (!manual_length_header && !headers.count("content-length") && !has_body_source())
             {
-                content_length_buffer = std::to_string(body.size());
+                content_length_buffer = std::to_string(body_size());
                 static std::string content_length_tag = "Content-Length: ";
                 buffers.emplace_back(content_length_tag.data(), content_length_tag.size());
                 buffers.emplace_back(content_length_buffer.data(), content_length_buffer.size());
@@ -9378,7 +10660,18 @@ namespace crow
         bool completed_{};
         std::function<void()> complete_request_handler_;
         std::function<bool()> is_alive_helper_;
+        std::function<void(std::size_t)> sent_handler_;
         static_file_info file_info;
+
+        /// A piece of borrowed body memory and what keeps it alive.
+        struct body_view
+        {
+            const char* data;
+            std::size_t size;
+            std::shared_ptr<const void> owner;
+        };
+        std::vector<body_view> body_views_;
+        std::shared_ptr<body_source> body_source_;
     };
 } // namespace crow
 
@@ -9612,7 +10905,7 @@ namespace crow
         void before_handle(request& req, response& res, context& ctx)
         {
             // TODO(dranikpg): remove copies, use string_view with c++17
-            int count = req.headers.count("Cookie");
+            int count = req.header_count("Cookie");
             if (!count)
                 return;
             if (count > 1)
@@ -9621,7 +10914,7 @@ namespace crow
                 res.end();
                 return;
             }
-            std::string cookies = req.get_header_value("Cookie");
+            std::string cookies(req.get_header_view("Cookie"));
             size_t pos = 0;
             while (pos < cookies.size())
             {
@@ -10666,9 +11959,20 @@ namespace crow
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#ifdef CROW_HAS_SENDFILE
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
 
 namespace crow
 {
@@ -10684,146 +11988,491 @@ namespace crow
     static std::atomic<int> connectionCount;
 #endif
 
-    /// An HTTP connection.
-    template<typename Adaptor, typename Handler, typename... Middlewares>
-    class Connection : public std::enable_shared_from_this<Connection<Adaptor, Handler, Middlewares...>>
+    namespace detail
     {
-        friend struct crow::response;
-
-    public:
-        Connection(
-          asio::io_context& io_context,
-          Handler* handler,
-          const std::string& server_name,
-          std::tuple<Middlewares...>* middlewares,
-          std::function<std::string()>& get_cached_date_str_f,
-          detail::task_timer& task_timer,
-          typename Adaptor::context* adaptor_ctx_,
-          std::atomic<unsigned int>& queue_length):
-          adaptor_(io_context, adaptor_ctx_),
-          handler_(handler),
-          parser_(this),
-          req_(parser_.req),
-          server_name_(server_name),
-          middlewares_(middlewares),
-          get_cached_date_str(get_cached_date_str_f),
-          task_timer_(task_timer),
-          res_stream_threshold_(handler->stream_threshold()),
-          queue_length_(queue_length)
+        /// Reads a static file's extents (with their multipart/byteranges part headers) through one small buffer,
+        /// for when the file can't be handed to the kernel with sendfile / splice.
+        class static_file_source : public body_source
         {
-            queue_length_++;
-#ifdef CROW_ENABLE_DEBUG
-            connectionCount++;
-            CROW_LOG_DEBUG << "Connection (" << this << ") allocated, total: " << connectionCount;
+        public:
+            explicit static_file_source(const response::static_file_info& info):
+#ifdef CROW_HAS_FILE_CACHE
+              file_(info.file),
 #endif
-        }
-
-        ~Connection()
-        {
-            queue_length_--;
-#ifdef CROW_ENABLE_DEBUG
-            connectionCount--;
-            CROW_LOG_DEBUG << "Connection (" << this << ") freed, total: " << connectionCount;
+              parts_(info.parts),
+              multipart_end_(info.multipart_end)
+            {
+                if (parts_.empty())
+                    parts_.push_back({std::string(), info.offset, info.length});
+#ifdef CROW_HAS_FILE_CACHE
+                if (!file_)
 #endif
-        }
-
-        /// The TCP socket on top of which the connection is established.
-        decltype(std::declval<Adaptor>().raw_socket())& socket()
-        {
-            return adaptor_.raw_socket();
-        }
+                    is_.open(info.path.c_str(), std::ios::in | std::ios::binary);
+            }
 
-        void start()
-        {
-            auto self = this->shared_from_this();
-            adaptor_.start([self](const error_code& ec) {
-                if (!ec)
+            void next(chunk_handler handler) override
+            {
+                while (part_ < parts_.size())
                 {
-                    self->start_deadline();
-                    self->parser_.clear();
-
-                    self->do_read();
+                    auto& part = parts_[part_];
+                    if (!part_started_)
+                    {
+                        part_started_ = true;
+                        is_.clear();
+                        is_.seekg(part.offset);
+                        offset_ = part.offset;
+                        remaining_ = part.length;
+                        if (!part.header.empty())
+                        {
+                            handler(true, part.header.data(), part.header.size(), nullptr);
+                            return;
+                        }
+                    }
+                    if (remaining_ > 0)
+                    {
+                        std::streamsize count = read(CROW_MIN(buffer_.size(), remaining_));
+                        if (count <= 0)
+                        {
+                            // The file got truncated after we announced its Content-Length
+                            handler(false, nullptr, 0, nullptr);
+                            return;
+                        }
+                        offset_ += count;
+                        remaining_ -= count;
+                        handler(true, buffer_.data(), count, nullptr);
+                        return;
+                    }
+                    part_++;
+                    part_started_ = false;
                 }
-                else
+                if (!multipart_end_.empty())
                 {
-                    CROW_LOG_ERROR << "Could not start adaptor: " << ec.message();
+                    handler(true, multipart_end_.data(), multipart_end_.size(), nullptr);
+                    multipart_end_.clear();
+                    return;
                 }
-            });
-        }
+                handler(true, nullptr, 0, nullptr);
+            }
 
-        void handle_url()
-        {
-            routing_handle_result_ = handler_->handle_initial(req_, res);
-            // if no route is found for the request method, return the response without parsing or processing anything further.
-            if (!routing_handle_result_->rule_index && !routing_handle_result_->catch_all)
+        private:
+            std::streamsize read(std::size_t size)
             {
-                parser_.done();
-                need_to_call_after_handlers_ = true;
-                complete_request();
+#ifdef CROW_HAS_FILE_CACHE
+                // The cached descriptor is shared, only ever read it at an explicit offset
+                if (file_)
+                    return ::pread(file_->fd, buffer_.data(), size, offset_);
+#endif
+                is_.read(buffer_.data(), size);
+                return is_.gcount();
             }
-        }
 
-        void handle_header()
+#ifdef CROW_HAS_FILE_CACHE
+            std::shared_ptr<const open_file> file_;
+#endif
+            std::ifstream is_;
+            std::vector<response::static_file_info::part> parts_;
+            std::string multipart_end_;
+            std::size_t part_ = 0;
+            bool part_started_ = false;
+            uint64_t offset_ = 0;
+            uint64_t remaining_ = 0;
+            std::array<char, 16384> buffer_;
+        };
+
+        /// Fixed-size blocks of memory kept for reuse instead of going back to the heap.
+        ///
+        /// The pool takes the size of the first block asked for, other sizes go straight to the heap. At most `max_free`
+        /// blocks are kept. Blocks may be returned from any thread.
+        class block_pool
         {
-            // HTTP 1.1 Expect: 100-continue
-            if (req_.http_ver_major == 1 && req_.http_ver_minor == 1 && get_header_value(req_.headers, "expect") == "100-continue")
+        public:
+            explicit block_pool(std::size_t max_free):
+              max_free_(max_free)
+            {}
+
+            ~block_pool()
             {
-                continue_requested = true;
-                buffers_.clear();
-                static std::string expect_100_continue = "HTTP/1.1 100 Continue\r\n\r\n";
-                buffers_.emplace_back(expect_100_continue.data(), expect_100_continue.size());
-                do_write_sync(buffers_);
+                for (void* block : free_)
+                    ::operator delete(block);
             }
-        }
-
-        void handle()
-        {
-            // TODO(EDev): cancel_deadline_timer should be looked into, it might be a good idea to add it to handle_url() and then restart the timer once everything passes
-            cancel_deadline_timer();
-            bool is_invalid_request = false;
-            add_keep_alive_ = false;
 
-            // Create context
-            ctx_ = detail::context<Middlewares...>();
-            req_.middleware_context = static_cast<void*>(&ctx_);
-            req_.middleware_container = static_cast<void*>(middlewares_);
-            req_.io_context = &adaptor_.get_io_context();
-            req_.remote_ip_address = adaptor_.address();
-            add_keep_alive_ = req_.keep_alive;
-            close_connection_ = req_.close_connection;
+            block_pool(const block_pool&) = delete;
+            block_pool& operator=(const block_pool&) = delete;
 
-            if (req_.check_version(1, 1)) // HTTP/1.1
+            void* allocate(std::size_t size)
             {
-                if (!req_.headers.count("host"))
-                {
-                    is_invalid_request = true;
-                    res = response(400);
-                }
-                else if (req_.upgrade)
                 {
-                    // h2 or h2c headers
-                    if (req_.get_header_value("upgrade").find("h2")==0)
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!block_size_)
+                        block_size_ = size;
+                    if (size == block_size_ && !free_.empty())
                     {
-                        // TODO(ipkn): HTTP/2
-                        // currently, ignore upgrade header
+                        void* block = free_.back();
+                        free_.pop_back();
+                        return block;
                     }
-                    else
-                    {
+                }
+                return ::operator new(size);
+            }
 
-                        detail::middleware_call_helper<detail::middleware_call_criteria_only_global,
-                                                       0, decltype(ctx_), decltype(*middlewares_)>({}, *middlewares_, req_, res, ctx_);
-                        close_connection_ = true;
-                        handler_->handle_upgrade(req_, res, std::move(adaptor_));
+            void deallocate(void* block, std::size_t size)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (size == block_size_ && free_.size() < max_free_)
+                    {
+                        free_.push_back(block);
                         return;
                     }
                 }
+                ::operator delete(block);
             }
 
-            CROW_LOG_INFO << "Request: " << utility::lexical_cast<std::string>(adaptor_.remote_endpoint()) << " " << this << " HTTP/" << (char)(req_.http_ver_major + '0') << "." << (char)(req_.http_ver_minor + '0') << ' ' << method_name(req_.method) << " " << req_.url;
+        private:
+            std::mutex mutex_;
+            std::vector<void*> free_;
+            std::size_t block_size_ = 0;
+            std::size_t max_free_;
+        };
 
+        /// An allocator for std::allocate_shared that takes single objects from a \ref block_pool.
+        ///
+        /// Every copy shares the pool, so it stays around for as long as something allocated from it does.
+        template<typename T>
+        struct pool_allocator
+        {
+            using value_type = T;
 
-            need_to_call_after_handlers_ = false;
-            if (!is_invalid_request)
+            explicit pool_allocator(std::shared_ptr<block_pool> pool_):
+              pool(std::move(pool_))
+            {}
+
+            template<typename U>
+            pool_allocator(const pool_allocator<U>& other):
+              pool(other.pool)
+            {}
+
+            T* allocate(std::size_t n)
+            {
+                if (n != 1)
+                    return static_cast<T*>(::operator new(n * sizeof(T)));
+                return static_cast<T*>(pool->allocate(sizeof(T)));
+            }
+
+            void deallocate(T* p, std::size_t n)
+            {
+                if (n != 1)
+                    ::operator delete(p);
+                else
+                    pool->deallocate(p, sizeof(T));
+            }
+
+            template<typename U>
+            bool operator==(const pool_allocator<U>& other) const
+            {
+                return pool == other.pool;
+            }
+
+            template<typename U>
+            bool operator!=(const pool_allocator<U>& other) const
+            {
+                return pool != other.pool;
+            }
+
+            std::shared_ptr<block_pool> pool;
+        };
+
+        /// Read buffers for connections, checked out for a read and returned once the connection has nothing left in them.
+        ///
+        /// Each thread keeps up to CROW_READ_BUFFER_POOL_SIZE returned buffers for its next reads, without locking.
+        class read_buffer_pool
+        {
+        public:
+            static constexpr std::size_t buffer_size = 4096;
+
+            struct releaser
+            {
+                void operator()(char* buffer) const
+                {
+                    auto& cache = thread_cache();
+                    if (cache.size() < CROW_READ_BUFFER_POOL_SIZE)
+                        cache.emplace_back(buffer);
+                    else
+                        delete[] buffer;
+                }
+            };
+            using buffer = std::unique_ptr<char[], releaser>;
+
+            static buffer acquire()
+            {
+                auto& cache = thread_cache();
+                if (cache.empty())
+                    return buffer(new char[buffer_size]);
+                char* reused = cache.back().release();
+                cache.pop_back();
+                return buffer(reused);
+            }
+
+        private:
+            static std::vector<std::unique_ptr<char[]>>& thread_cache()
+            {
+                thread_local std::vector<std::unique_ptr<char[]>> cache;
+                return cache;
+            }
+        };
+    } // namespace detail
+
+#ifdef CROW_ENABLE_COMPRESSION
+    namespace compression
+    {
+        /// Compressed copies of recently sent bodies, shared by every connection.
+        ///
+        /// Entries are found by a hash of the uncompressed body, so a body that's sent again (a playlist, the same JSON) costs a hash,
+        /// a lookup and a comparison instead of running zlib, whichever route produced it. std::hash isn't collision resistant and a
+        /// client may control a body, so every entry keeps the body it was compressed from and a hit is only one when that is equal.
+        /// The cache is bounded by the bytes of both (CROW_COMPRESSION_CACHE_SIZE) and drops the least recently used entries beyond that.
+        class response_cache
+        {
+        public:
+            using entry = std::shared_ptr<const std::string>;
+
+            static response_cache& instance()
+            {
+                static response_cache cache;
+                return cache;
+            }
+
+            /// The body compressed with `algo`, nullptr if compression failed.
+            entry compress(const std::string& body, algorithm algo)
+            {
+                key k{std::hash<std::string>()(body), body.size(), algo};
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    auto it = index_.find(k);
+                    // Another body with the same hash is simply compressed afresh
+                    if (it != index_.end() && *it->second->original == body)
+                    {
+                        lru_.splice(lru_.begin(), lru_, it->second);
+                        return it->second->data;
+                    }
+                }
+
+                auto compressed = std::make_shared<const std::string>(compress_string(body, algo));
+                if (compressed->empty())
+                    return nullptr;
+                // A single entry may not take more than an eighth of the cache
+                std::size_t size = compressed->size() + body.size();
+                if (size > CROW_COMPRESSION_CACHE_SIZE / 8)
+                    return compressed;
+
+                auto original = std::make_shared<const std::string>(body);
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (index_.count(k))
+                    return compressed;
+                while (!lru_.empty() && used_ + size > CROW_COMPRESSION_CACHE_SIZE)
+                {
+                    used_ -= lru_.back().data->size() + lru_.back().original->size();
+                    index_.erase(lru_.back().k);
+                    lru_.pop_back();
+                }
+                used_ += size;
+                lru_.push_front({k, std::move(original), compressed});
+                index_.emplace(k, lru_.begin());
+                return compressed;
+            }
+
+        private:
+            struct key
+            {
+                std::size_t hash;
+                std::size_t size;
+                algorithm algo;
+
+                bool operator==(const key& other) const
+                {
+                    return hash == other.hash && size == other.size && algo == other.algo;
+                }
+            };
+
+            struct key_hash
+            {
+                std::size_t operator()(const key& k) const
+                {
+                    return k.hash ^ static_cast<std::size_t>(k.algo);
+                }
+            };
+
+            struct node
+            {
+                key k;
+                std::shared_ptr<const std::string> original; ///< The body `data` was compressed from.
+                entry data;
+            };
+
+            std::mutex mutex_;
+            std::list<node> lru_; ///< Most recently used first.
+            std::unordered_map<key, std::list<node>::iterator, key_hash> index_;
+            std::size_t used_ = 0;
+        };
+    } // namespace compression
+#endif
+
+    /// An HTTP connection.
+    template<typename Adaptor, typename Handler, typename... Middlewares>
+    class Connection : public std::enable_shared_from_this<Connection<Adaptor, Handler, Middlewares...>>
+    {
+        friend struct crow::response;
+
+    public:
+        Connection(
+          asio::io_context& io_context,
+          Handler* handler,
+          const std::string& server_name,
+          std::tuple<Middlewares...>* middlewares,
+          std::function<std::string()>& get_cached_date_str_f,
+          detail::task_timer& task_timer,
+          typename Adaptor::context* adaptor_ctx_,
+          std::atomic<unsigned int>& queue_length):
+          adaptor_(io_context, adaptor_ctx_),
+          handler_(handler),
+          request_views_(handler->request_views_used()),
+          parser_(this),
+          req_(parser_.req),
+          server_name_(server_name),
+          middlewares_(middlewares),
+          get_cached_date_str(get_cached_date_str_f),
+          task_timer_(task_timer),
+          deadline_([this] {
+              if (!adaptor_.is_open())
+              {
+                  return;
+              }
+              adaptor_.shutdown_readwrite();
+              adaptor_.close();
+          }),
+          res_stream_threshold_(handler->stream_threshold()),
+          queue_length_(queue_length)
+        {
+            parser_.use_views(request_views_);
+            queue_length_++;
+#ifdef CROW_ENABLE_DEBUG
+            connectionCount++;
+            CROW_LOG_DEBUG << "Connection (" << this << ") allocated, total: " << connectionCount;
+#endif
+        }
+
+        ~Connection()
+        {
+            close_static_file();
+            close_pipe();
+            queue_length_--;
+#ifdef CROW_ENABLE_DEBUG
+            connectionCount--;
+            CROW_LOG_DEBUG << "Connection (" << this << ") freed, total: " << connectionCount;
+#endif
+        }
+
+        /// The TCP socket on top of which the connection is established.
+        decltype(std::declval<Adaptor>().raw_socket())& socket()
+        {
+            return adaptor_.raw_socket();
+        }
+
+        void start()
+        {
+            auto self = this->shared_from_this();
+            adaptor_.start([self](const error_code& ec) {
+                if (!ec)
+                {
+                    self->start_deadline();
+                    self->parser_.clear();
+
+                    self->do_read();
+                }
+                else
+                {
+                    CROW_LOG_ERROR << "Could not start adaptor: " << ec.message();
+                }
+            });
+        }
+
+        void handle_url()
+        {
+            routing_handle_result_ = handler_->handle_initial(req_, res);
+            // if no route is found for the request method, return the response without parsing or processing anything further.
+            if (!routing_handle_result_->rule_index && !routing_handle_result_->catch_all)
+            {
+                parser_.done();
+                need_to_call_after_handlers_ = true;
+                complete_request();
+            }
+        }
+
+        void handle_header()
+        {
+            // HTTP 1.1 Expect: 100-continue
+            if (req_.http_ver_major == 1 && req_.http_ver_minor == 1 && req_.get_header_view("expect") == "100-continue")
+            {
+                continue_requested = true;
+                buffers_.clear();
+                static std::string expect_100_continue = "HTTP/1.1 100 Continue\r\n\r\n";
+                // Responses to earlier pipelined requests have to go first
+                take_batch();
+                buffers_.emplace_back(expect_100_continue.data(), expect_100_continue.size());
+                release_batch(do_write_sync(buffers_));
+            }
+        }
+
+        void handle()
+        {
+            // TODO(EDev): cancel_deadline_timer should be looked into, it might be a good idea to add it to handle_url() and then restart the timer once everything passes
+            cancel_deadline_timer();
+            bool is_invalid_request = false;
+            add_keep_alive_ = false;
+
+            // Create context
+            ctx_ = detail::context<Middlewares...>();
+            req_.middleware_context = static_cast<void*>(&ctx_);
+            req_.middleware_container = static_cast<void*>(middlewares_);
+            req_.io_context = &adaptor_.get_io_context();
+            req_.remote_ip_address = adaptor_.address();
+            add_keep_alive_ = req_.keep_alive;
+            close_connection_ = req_.close_connection;
+
+            if (req_.check_version(1, 1)) // HTTP/1.1
+            {
+                if (!req_.header_count("host"))
+                {
+                    is_invalid_request = true;
+                    res = response(400);
+                }
+                else if (req_.upgrade)
+                {
+                    // h2 or h2c headers
+                    if (req_.get_header_view("upgrade").find("h2")==0)
+                    {
+                        // TODO(ipkn): HTTP/2
+                        // currently, ignore upgrade header
+                    }
+                    else
+                    {
+
+                        detail::middleware_call_helper<detail::middleware_call_criteria_only_global,
+                                                       0, decltype(ctx_), decltype(*middlewares_)>({}, *middlewares_, req_, res, ctx_);
+                        close_connection_ = true;
+                        // The connection's read buffer goes away with it
+                        req_.own();
+                        handler_->handle_upgrade(req_, res, std::move(adaptor_));
+                        return;
+                    }
+                }
+            }
+
+            CROW_LOG_INFO << "Request: " << utility::lexical_cast<std::string>(adaptor_.remote_endpoint()) << " " << this << " HTTP/" << (char)(req_.http_ver_major + '0') << "." << (char)(req_.http_ver_minor + '0') << ' ' << method_name(req_.method) << " " << req_.url_view();
+
+
+            need_to_call_after_handlers_ = false;
+            if (!is_invalid_request)
             {
                 res.complete_request_handler_ = nullptr;
                 auto self = this->shared_from_this();
@@ -10844,210 +12493,760 @@ namespace crow
                     if (add_keep_alive_)
                         res.set_header("connection", "Keep-Alive");
                 }
-                else
+                else
+                {
+                    complete_request();
+                }
+            }
+            else
+            {
+                complete_request();
+            }
+        }
+
+        /// Call the after handle middleware and send the write the response to the connection.
+        void complete_request()
+        {
+            if (batch_writing_)
+            {
+                // A handler that ended asynchronously, its response waits for the batch in flight
+                complete_after_batch_ = true;
+                return;
+            }
+            CROW_LOG_INFO << "Response: " << this << ' ' << (req_.has_views ? req_.views.raw_url : std::string_view(req_.raw_url)) << ' ' << res.code << ' ' << close_connection_;
+            res.is_alive_helper_ = nullptr;
+
+            if (need_to_call_after_handlers_)
+            {
+                need_to_call_after_handlers_ = false;
+
+                // call all after_handler of middlewares
+                detail::after_handlers_call_helper<
+                  detail::middleware_call_criteria_only_global,
+                  (static_cast<int>(sizeof...(Middlewares)) - 1),
+                  decltype(ctx_),
+                  decltype(*middlewares_)>({}, *middlewares_, ctx_, req_, res);
+            }
+#ifdef CROW_ENABLE_COMPRESSION
+            if (!res.body.empty() && handler_->compression_used())
+            {
+                std::string_view accept_encoding = req_.get_header_view("Accept-Encoding");
+                if (!accept_encoding.empty() && res.compressed)
+                {
+                    switch (handler_->compression_algorithm())
+                    {
+                        case compression::DEFLATE:
+                            if (accept_encoding.find("deflate") != std::string::npos)
+                            {
+                                compress_body(compression::algorithm::DEFLATE);
+                                res.set_header("Content-Encoding", "deflate");
+                            }
+                            break;
+                        case compression::GZIP:
+                            if (accept_encoding.find("gzip") != std::string::npos)
+                            {
+                                compress_body(compression::algorithm::GZIP);
+                                res.set_header("Content-Encoding", "gzip");
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+#endif
+
+            if (res.is_static_type() && (req_.method == HTTPMethod::Get || req_.method == HTTPMethod::Head))
+            {
+                if (handler_->precompressed_used())
+                    res.use_precompressed_file(req_.get_header_view("Accept-Encoding"));
+
+                std::string_view range = req_.get_header_view("Range");
+                if (!range.empty())
+                    res.set_static_file_range(range, req_.get_header_view("If-Range"));
+            }
+
+            if (res.has_body_source() && !res.headers.count("Content-Length") && req_.check_version(1, 0))
+            {
+                // No chunked encoding in HTTP/1.0, the end of the body is marked by closing the connection
+                res.headers.erase("Transfer-Encoding");
+                close_connection_ = true;
+            }
+
+            prepare_buffers();
+
+            if (res.is_static_type())
+            {
+                do_write_static();
+            }
+            else
+            {
+                do_write_general();
+            }
+        }
+
+    private:
+#ifdef CROW_ENABLE_COMPRESSION
+        /// Replace the body by its compressed form, borrowed from the response cache when the same body was compressed before.
+        void compress_body(compression::algorithm algo)
+        {
+            if (CROW_COMPRESSION_CACHE_SIZE == 0)
+            {
+                res.body = compression::compress_string(res.body, algo);
+                return;
+            }
+            auto compressed = compression::response_cache::instance().compress(res.body, algo);
+            if (compressed)
+                res.set_body_view(compressed->data(), compressed->size(), compressed);
+            else
+                res.body.clear();
+        }
+#endif
+
+        void prepare_buffers()
+        {
+            res.complete_request_handler_ = nullptr;
+            res.is_alive_helper_ = nullptr;
+
+            if (!adaptor_.is_open())
+            {
+                //CROW_LOG_DEBUG << this << " delete (socket is closed) " << is_reading << ' ' << is_writing;
+                //delete this;
+                return;
+            }
+            res.write_header_into_buffer(buffers_, content_length_, add_keep_alive_, server_name_);
+        }
+
+        void do_write_static()
+        {
+#ifdef CROW_HAS_SENDFILE
+            if constexpr (Adaptor::supports_sendfile)
+            {
+                if (res.file_info.statResult == 0 && !res.skip_body)
+                {
+#ifdef CROW_HAS_FILE_CACHE
+                    // Borrowed from the cache, which keeps it open for as long as static_file_ holds on to it
+                    static_file_ = res.file_info.file;
+                    static_fd_ = static_file_ ? static_file_->fd : -1;
+#else
+                    static_fd_ = ::open(res.file_info.path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+                    if (static_fd_ >= 0)
+                    {
+                        static_part_ = 0;
+                        body_bytes_sent_ = 0;
+                        is_writing_ = true;
+                        parser_.pause();
+                        take_batch();
+
+                        auto self = this->shared_from_this();
+                        bool body_follows = res.file_info.length > 0 || !res.file_info.parts.empty();
+                        write_before_file(buffers_, body_follows, [self] {
+                            self->do_write_static_part();
+                        });
+                        return;
+                    }
+                    CROW_LOG_WARNING << "Could not open " << res.file_info.path << " for sendfile, falling back to a buffered copy";
+                }
+            }
+#endif
+            if (res.file_info.statResult == 0 && !res.skip_body)
+            {
+                // No sendfile here (TLS, not Linux, or disabled): stream the file through a buffer instead
+                res.body_source_ = std::make_shared<detail::static_file_source>(res.file_info);
+                do_write_source();
+                return;
+            }
+            do_write_async(asio::buffer_size(buffers_));
+        }
+
+        void do_write_general()
+        {
+            if (res.has_body_source())
+            {
+                do_write_source();
+                return;
+            }
+            if (res.has_body_view())
+            {
+                do_write_view();
+                return;
+            }
+
+            if (res.body.length() < res_stream_threshold_)
+            {
+                auto sent_handler = std::move(res.sent_handler_);
+                res_body_copy_.swap(res.body);
+
+                if (parsing_)
+                {
+                    // More pipelined requests may follow in what was read, their responses go out together
+                    batch_response(std::move(sent_handler));
+                }
+                else
+                {
+                    buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+
+                    std::size_t length = res_body_copy_.size();
+                    bool ok = do_write_sync(buffers_);
+                    if (sent_handler)
+                        sent_handler(ok ? length : 0);
+                }
+
+                if (need_to_start_read_after_complete_)
+                {
+                    need_to_start_read_after_complete_ = false;
+                    start_deadline();
+                    do_read();
+                }
+            }
+            else
+            {
+                // Large bodies go out asynchronously, a slow client mustn't hold up the whole io_context thread
+                std::size_t header_size = asio::buffer_size(buffers_);
+                res_body_copy_.swap(res.body);
+                buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                do_write_async(header_size);
+            }
+        }
+
+        /// Write the headers and every piece of the borrowed body in one gather write, the owners are released once it completes.
+        void do_write_view()
+        {
+            if (parsing_)
+            {
+                batch_response(std::move(res.sent_handler_));
+                return;
+            }
+
+            std::size_t header_size = asio::buffer_size(buffers_);
+            if (!res.skip_body)
+            {
+                for (auto& view : res.body_views_)
+                    buffers_.emplace_back(view.data, view.size);
+            }
+            do_write_async(header_size);
+        }
+
+        /// Write everything in buffers_ asynchronously and finish the response, the first `header_size` bytes not being body.
+        void do_write_async(std::size_t header_size)
+        {
+            header_size += take_batch();
+            cancel_deadline_timer();
+            body_bytes_sent_ = 0;
+            is_writing_ = true;
+            parser_.pause();
+
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), buffers_,
+              [self, header_size](const error_code& ec, std::size_t bytes_transferred) {
+                  self->body_bytes_sent_ = bytes_transferred > header_size ? bytes_transferred - header_size : 0;
+                  self->finish_write(ec);
+              });
+        }
+
+        /// Pull the body from its source one chunk at a time, each one once the previous is on the wire.
+        /// The headers wait for the first chunk and go out in the same write, a small body is a single packet.
+        void do_write_source()
+        {
+            body_source_ = std::move(res.body_source_);
+            source_chunked_ = res.get_header_value("Transfer-Encoding") == "chunked";
+            source_headers_pending_ = true;
+            take_batch();
+
+            cancel_deadline_timer();
+            body_bytes_sent_ = 0;
+            is_writing_ = true;
+            parser_.pause();
+
+            pull_source_chunk();
+        }
+
+        void pull_source_chunk()
+        {
+            auto self = this->shared_from_this();
+            body_source_->next([self](bool ok, const char* data, std::size_t size, std::shared_ptr<const void> owner) {
+                self->write_source_chunk(ok, data, size, std::move(owner));
+            });
+        }
+
+        void write_source_chunk(bool ok, const char* data, std::size_t size, std::shared_ptr<const void> owner)
+        {
+            if (!ok)
+            {
+                // Too late to change the status, all that's left is to cut the response short
+                CROW_LOG_ERROR << this << " body source failed after " << body_bytes_sent_ << " bytes";
+                close_connection_ = true;
+                finish_write(error_code());
+                return;
+            }
+            if (size == 0 && !source_chunked_ && !source_headers_pending_)
+            {
+                finish_write(error_code());
+                return;
+            }
+
+            // The headers are still in buffers_ ahead of the first chunk
+            if (!source_headers_pending_)
+                buffers_.clear();
+            source_headers_pending_ = false;
+            if (source_chunked_)
+            {
+                static const char hex[] = "0123456789abcdef";
+                chunk_header_.clear();
+                for (std::size_t n = size; n > 0 || chunk_header_.empty(); n >>= 4)
+                    chunk_header_.insert(chunk_header_.begin(), hex[n & 0xf]);
+                chunk_header_ += "\r\n";
+                buffers_.emplace_back(chunk_header_.data(), chunk_header_.size());
+            }
+            if (size > 0)
+                buffers_.emplace_back(data, size);
+            if (source_chunked_)
+                buffers_.emplace_back(crlf.data(), crlf.size()); // after the last, empty, chunk this ends the body
+
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), buffers_,
+              [self, size, owner](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                  if (!ec)
+                      self->body_bytes_sent_ += size;
+                  if (ec || size == 0)
+                      self->finish_write(ec);
+                  else
+                      self->pull_source_chunk();
+              });
+        }
+
+#ifdef CROW_HAS_SENDFILE
+        /// Start on the next extent of the static file, preceded by its part header when answering several ranges.
+        void do_write_static_part()
+        {
+            auto self = this->shared_from_this();
+            auto& info = res.file_info;
+
+            if (info.parts.empty())
+            {
+                if (static_part_++ > 0)
+                {
+                    finish_write(error_code());
+                    return;
+                }
+                static_offset_ = info.offset;
+                static_end_ = info.offset + info.length;
+                continue_static_transfer();
+                return;
+            }
+
+            if (static_part_ == info.parts.size())
+            {
+                static_part_++;
+                asio::async_write(
+                  adaptor_.socket(), asio::buffer(info.multipart_end),
+                  [self](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                      self->finish_write(ec);
+                  });
+                return;
+            }
+
+            auto& part = info.parts[static_part_++];
+            static_offset_ = part.offset;
+            static_end_ = part.offset + part.length;
+            write_before_file({asio::buffer(part.header)}, true, [self] {
+                self->continue_static_transfer();
+            });
+        }
+
+        /// Write `buffers` (headers, a part header) ahead of file data, then call `next`.
+
+        ///
+        /// When `body_follows` they are sent with MSG_MORE so that the kernel holds them back and they share packets with the sendfile /
+        /// splice that follows instead of going out on their own (holding back the headers of an empty file would only delay them).
+        /// Whatever the socket can't take right away is written asynchronously, as is all of it when there are more buffers than
+        /// a single sendmsg() takes.
+        template<typename Next>
+        void write_before_file(const std::vector<asio::const_buffer>& buffers, bool body_follows, Next next)
+        {
+            std::size_t total = asio::buffer_size(buffers);
+            ssize_t sent = 0;
+            if (body_follows && buffers.size() <= IOV_MAX)
+            {
+                file_iov_.clear();
+                for (auto& buffer : buffers)
+                    file_iov_.push_back({const_cast<void*>(buffer.data()), buffer.size()});
+                msghdr msg{};
+                msg.msg_iov = file_iov_.data();
+                msg.msg_iovlen = file_iov_.size();
+                do
+                    sent = ::sendmsg(adaptor_.raw_socket().native_handle(), &msg, MSG_MORE | MSG_DONTWAIT | MSG_NOSIGNAL);
+                while (sent < 0 && errno == EINTR);
+                if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    finish_write(error_code(errno, asio::error::get_system_category()));
+                    return;
+                }
+                if (sent < 0)
+                    sent = 0;
+                if (static_cast<std::size_t>(sent) == total)
                 {
-                    complete_request();
+                    next();
+                    return;
                 }
             }
-            else
+
+            // The rest goes the usual way
+            file_prefix_.clear();
+            for (auto& buffer : buffers)
             {
-                complete_request();
+                std::size_t skip = CROW_MIN(buffer.size(), static_cast<std::size_t>(sent));
+                sent -= skip;
+                if (skip < buffer.size())
+                    file_prefix_.push_back(buffer + skip);
             }
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), file_prefix_,
+              [self, next](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                  if (ec)
+                      self->finish_write(ec);
+                  else
+                      next();
+              });
         }
 
-        /// Call the after handle middleware and send the write the response to the connection.
-        void complete_request()
+        void continue_static_transfer()
         {
-            CROW_LOG_INFO << "Response: " << this << ' ' << req_.raw_url << ' ' << res.code << ' ' << close_connection_;
-            res.is_alive_helper_ = nullptr;
+            if (res.file_info.transfer == response::file_transfer::splice)
+                do_splice();
+            else
+                do_sendfile();
+        }
 
-            if (need_to_call_after_handlers_)
-            {
-                need_to_call_after_handlers_ = false;
+        /// Let the kernel copy the static file into the socket, waiting for writability whenever the send buffer is full.
+        void do_sendfile()
+        {
+            auto self = this->shared_from_this();
+            auto& socket = adaptor_.raw_socket();
 
-                // call all after_handler of middlewares
-                detail::after_handlers_call_helper<
-                  detail::middleware_call_criteria_only_global,
-                  (static_cast<int>(sizeof...(Middlewares)) - 1),
-                  decltype(ctx_),
-                  decltype(*middlewares_)>({}, *middlewares_, ctx_, req_, res);
+            error_code ec;
+            socket.native_non_blocking(true, ec);
+            if (ec)
+            {
+                finish_write(ec);
+                return;
             }
-#ifdef CROW_ENABLE_COMPRESSION
-            if (!res.body.empty() && handler_->compression_used())
+
+            std::size_t budget = CROW_SENDFILE_CHUNK_SIZE;
+            while (static_offset_ < static_end_)
             {
-                std::string accept_encoding = req_.get_header_value("Accept-Encoding");
-                if (!accept_encoding.empty() && res.compressed)
+                std::size_t count = CROW_MIN(static_cast<std::size_t>(static_end_ - static_offset_), budget);
+                ssize_t sent = ::sendfile(socket.native_handle(), static_fd_, &static_offset_, count);
+                if (sent > 0)
                 {
-                    switch (handler_->compression_algorithm())
+                    body_bytes_sent_ += sent;
+                    budget -= sent;
+                    if (budget == 0)
                     {
-                        case compression::DEFLATE:
-                            if (accept_encoding.find("deflate") != std::string::npos)
-                            {
-                                res.body = compression::compress_string(res.body, compression::algorithm::DEFLATE);
-                                res.set_header("Content-Encoding", "deflate");
-                            }
-                            break;
-                        case compression::GZIP:
-                            if (accept_encoding.find("gzip") != std::string::npos)
-                            {
-                                res.body = compression::compress_string(res.body, compression::algorithm::GZIP);
-                                res.set_header("Content-Encoding", "gzip");
-                            }
-                            break;
-                        default:
-                            break;
+                        // Don't starve the other connections sharing this io_context
+                        asio::post(adaptor_.get_io_context(), [self] {
+                            self->do_sendfile();
+                        });
+                        return;
                     }
                 }
+                else if (sent < 0 && errno == EAGAIN)
+                {
+                    socket.async_wait(asio::socket_base::wait_write, [self](const error_code& ec) {
+                        if (ec)
+                            self->finish_write(ec);
+                        else
+                            self->do_sendfile();
+                    });
+                    return;
+                }
+                else if (sent < 0 && errno != EINTR)
+                {
+                    finish_write(error_code(errno, asio::error::get_system_category()));
+                    return;
+                }
+                else if (sent == 0)
+                {
+                    // The file got truncated after we announced its Content-Length
+                    finish_write(asio::error::eof);
+                    return;
+                }
             }
-#endif
-
-            prepare_buffers();
-
-            if (res.is_static_type())
-            {
-                do_write_static();
-            }
-            else
-            {
-                do_write_general();
-            }
+            do_write_static_part();
         }
 
-    private:
-        void prepare_buffers()
+        /// Move the static file through a pipe with splice(2): file pages are spliced into the pipe, and the pipe into the socket.
+        void do_splice()
         {
-            res.complete_request_handler_ = nullptr;
-            res.is_alive_helper_ = nullptr;
+            auto self = this->shared_from_this();
+            auto& socket = adaptor_.raw_socket();
 
-            if (!adaptor_.is_open())
+            error_code ec;
+            socket.native_non_blocking(true, ec);
+            if (!ec && pipe_fds_[0] < 0 && ::pipe2(pipe_fds_, O_NONBLOCK | O_CLOEXEC) != 0)
+                ec = error_code(errno, asio::error::get_system_category());
+            if (ec)
             {
-                //CROW_LOG_DEBUG << this << " delete (socket is closed) " << is_reading << ' ' << is_writing;
-                //delete this;
+                finish_write(ec);
                 return;
             }
-            res.write_header_into_buffer(buffers_, content_length_, add_keep_alive_, server_name_);
+
+            std::size_t budget = CROW_SENDFILE_CHUNK_SIZE;
+            while (static_offset_ < static_end_ || pipe_fill_ > 0)
+            {
+                if (pipe_fill_ == 0)
+                {
+                    std::size_t count = CROW_MIN(static_cast<std::size_t>(static_end_ - static_offset_), budget);
+                    ssize_t filled = ::splice(static_fd_, &static_offset_, pipe_fds_[1], nullptr, count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                    if (filled > 0)
+                        pipe_fill_ = filled;
+                    else if (filled == 0)
+                    {
+                        // The file got truncated after we announced its Content-Length
+                        finish_write(asio::error::eof);
+                        return;
+                    }
+                    else if (errno != EINTR)
+                    {
+                        finish_write(error_code(errno, asio::error::get_system_category()));
+                        return;
+                    }
+                    continue;
+                }
+
+                // Only hint at more data when there is some, or the tail of the file sits in the socket until the cork timer fires
+                bool more = static_offset_ < static_end_ || static_part_ <= res.file_info.parts.size();
+                ssize_t sent = ::splice(pipe_fds_[0], nullptr, socket.native_handle(), nullptr, pipe_fill_,
+                                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK | (more ? SPLICE_F_MORE : 0));
+                if (sent > 0)
+                {
+                    pipe_fill_ -= sent;
+                    body_bytes_sent_ += sent;
+                    budget -= CROW_MIN(budget, static_cast<std::size_t>(sent));
+                    if (budget == 0)
+                    {
+                        // Don't starve the other connections sharing this io_context
+                        asio::post(adaptor_.get_io_context(), [self] {
+                            self->do_splice();
+                        });
+                        return;
+                    }
+                }
+                else if (sent < 0 && errno == EAGAIN)
+                {
+                    socket.async_wait(asio::socket_base::wait_write, [self](const error_code& ec) {
+                        if (ec)
+                            self->finish_write(ec);
+                        else
+                            self->do_splice();
+                    });
+                    return;
+                }
+                else if (sent == 0 || errno != EINTR)
+                {
+                    finish_write(sent == 0 ? error_code(asio::error::eof) : error_code(errno, asio::error::get_system_category()));
+                    return;
+                }
+            }
+            do_write_static_part();
         }
+#endif
 
-        void do_write_static()
+        /// Wrap up an asynchronous response write and pick up the connection where the read side left it.
+        void finish_write(const error_code& ec)
         {
-            asio::write(adaptor_.socket(), buffers_);
+            is_writing_ = false;
+            close_static_file();
+            body_source_.reset();
+            std::string().swap(res_body_copy_);
+            auto sent_handler = std::move(res.sent_handler_);
 
-            if (res.file_info.statResult == 0)
+            if (ec)
             {
-                std::ifstream is(res.file_info.path.c_str(), std::ios::in | std::ios::binary);
-                std::vector<asio::const_buffer> buffers{1};
-                char buf[16384];
-                is.read(buf, sizeof(buf));
-                while (is.gcount() > 0)
-                {
-                    buffers[0] = asio::buffer(buf, is.gcount());
-                    do_write_sync(buffers);
-                    is.read(buf, sizeof(buf));
-                }
+                CROW_LOG_ERROR << ec << " - happened while sending buffers";
+                close_connection_ = true;
             }
             if (close_connection_)
             {
                 adaptor_.shutdown_readwrite();
                 adaptor_.close();
-                CROW_LOG_DEBUG << this << " from write (static)";
+                CROW_LOG_DEBUG << this << " from write (async)";
             }
 
             res.end();
             res.clear();
             buffers_.clear();
             parser_.clear();
+            // Responses that went out ahead of this one
+            release_batch(!ec);
+            if (sent_handler)
+                sent_handler(body_bytes_sent_);
+
+            continue_pipeline();
         }
 
-        void do_write_general()
+        /// After a write, handle the pipelined requests that may still be sitting in buffer_ before reading more.
+        void continue_pipeline()
         {
-            if (res.body.length() < res_stream_threshold_)
+            if (!adaptor_.is_open())
+                return;
+
+            bool read_deferred = need_to_start_read_after_complete_;
+            need_to_start_read_after_complete_ = false;
+            if (!parse_pipelined([this] {
+                    return parser_.resume();
+                }))
             {
-                res_body_copy_.swap(res.body);
-                buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                cancel_deadline_timer();
+                parser_.done();
+                adaptor_.shutdown_read();
+                adaptor_.close();
+                CROW_LOG_DEBUG << this << " from write (async) with description: \"" << http_errno_description(static_cast<http_errno>(parser_.http_errno)) << '\"';
+                return;
+            }
+            need_to_start_read_after_complete_ = need_to_start_read_after_complete_ || read_deferred;
 
-                do_write_sync(buffers_);
+            if (need_to_start_read_after_complete_ && !is_writing_ && !need_to_call_after_handlers_ && adaptor_.is_open())
+            {
+                need_to_start_read_after_complete_ = false;
+                start_deadline();
+                do_read();
+            }
+        }
 
-                if (need_to_start_read_after_complete_)
-                {
-                    need_to_start_read_after_complete_ = false;
-                    start_deadline();
-                    do_read();
-                }
+        void close_static_file()
+        {
+#ifdef CROW_HAS_SENDFILE
+#ifdef CROW_HAS_FILE_CACHE
+            if (static_file_)
+            {
+                static_file_.reset();
+                static_fd_ = -1;
             }
-            else
+#endif
+            if (static_fd_ >= 0)
             {
-                asio::write(adaptor_.socket(), buffers_); // Write the response start / headers
-                cancel_deadline_timer();
-                if (res.body.length() > 0)
+                ::close(static_fd_);
+                static_fd_ = -1;
+            }
+            // A pipe still holding data from an aborted splice can't be reused for the next response
+            if (pipe_fill_ > 0)
+                close_pipe();
+#endif
+        }
+
+        void close_pipe()
+        {
+#ifdef CROW_HAS_SENDFILE
+            if (pipe_fds_[0] >= 0)
+            {
+                ::close(pipe_fds_[0]);
+                ::close(pipe_fds_[1]);
+                pipe_fds_[0] = pipe_fds_[1] = -1;
+            }
+            pipe_fill_ = 0;
+#endif
+        }
+
+        void do_read()
+        {
+            constexpr std::size_t buffer_size = detail::read_buffer_pool::buffer_size;
+
+            // The views of a message that isn't complete point into buffer_, the rest of it has to go after them
+            std::size_t offset = 0;
+            if (request_views_ && parser_.in_message())
+            {
+                if (buffer_size - read_end_ >= buffer_size / 4)
+                    offset = read_end_;
+                else
                 {
-                    std::vector<asio::const_buffer> buffers{1};
-                    const uint8_t* data = reinterpret_cast<const uint8_t*>(res.body.data());
-                    size_t length = res.body.length();
-                    for (size_t transferred = 0; transferred < length;)
-                    {
-                        size_t to_transfer = CROW_MIN(16384UL, length - transferred);
-                        buffers[0] = asio::const_buffer(data + transferred, to_transfer);
-                        do_write_sync(buffers);
-                        transferred += to_transfer;
-                    }
+                    // The request was routed as soon as its URL was parsed, its string parameters move along with the URL
+                    std::string_view url = req_.url_view();
+                    parser_.own_views(buffer_.get(), buffer_.get() + buffer_size);
+                    if (routing_handle_result_)
+                        routing_handle_result_->r_params.move_string_params(url, req_.url_view());
                 }
-                if (close_connection_)
+            }
+
+            if constexpr (Adaptor::can_wait_readable)
+            {
+                if (!parser_.in_message())
                 {
-                    adaptor_.shutdown_readwrite();
-                    adaptor_.close();
-                    CROW_LOG_DEBUG << this << " from write (res_stream)";
+                    // Nothing refers to the buffer between requests: an idle connection gives it back and only waits for data
+                    buffer_.reset();
+                    auto self = this->shared_from_this();
+                    adaptor_.raw_socket().async_wait(asio::socket_base::wait_read, [self](const error_code& ec) {
+                        if (ec)
+                            self->read_some(0, ec);
+                        else
+                            self->do_read_into_buffer(0);
+                    });
+                    return;
                 }
-
-                res.end();
-                res.clear();
-                buffers_.clear();
-                parser_.clear();
             }
+            do_read_into_buffer(offset);
         }
 
-        void do_read()
+        /// Read into buffer_ from `offset` on, checking a buffer out first if the connection doesn't hold one.
+        void do_read_into_buffer(std::size_t offset)
         {
+            if (!buffer_)
+                buffer_ = detail::read_buffer_pool::acquire();
+
             auto self = this->shared_from_this();
             adaptor_.socket().async_read_some(
-              asio::buffer(buffer_),
-              [self](const error_code& ec, std::size_t bytes_transferred) {
-                  bool error_while_reading = true;
-                  if (!ec)
-                  {
-                      bool ret = self->parser_.feed(self->buffer_.data(), bytes_transferred);
-                      if (ret && self->adaptor_.is_open())
-                      {
-                          error_while_reading = false;
-                      }
-                  }
-
-                  if (error_while_reading)
-                  {
-                      self->cancel_deadline_timer();
-                      self->parser_.done();
-                      self->adaptor_.shutdown_read();
-                      self->adaptor_.close();
-                      CROW_LOG_DEBUG << self << " from read(1) with description: \"" << http_errno_description(static_cast<http_errno>(self->parser_.http_errno)) << '\"';
-                  }
-                  else if (self->close_connection_)
-                  {
-                      self->cancel_deadline_timer();
-                      self->parser_.done();
-                      // adaptor will close after write
-                  }
-                  else if (!self->need_to_call_after_handlers_)
-                  {
-                      self->start_deadline();
-                      self->do_read();
-                  }
-                  else
-                  {
-                      // res will be completed later by user
-                      self->need_to_start_read_after_complete_ = true;
-                  }
+              asio::buffer(buffer_.get() + offset, detail::read_buffer_pool::buffer_size - offset),
+              [self, offset](const error_code& ec, std::size_t bytes_transferred) {
+                  self->read_some(offset, ec, bytes_transferred);
               });
         }
 
+        /// Handle the outcome of a read that put `bytes_transferred` bytes into buffer_ at `offset`.
+        void read_some(std::size_t offset, const error_code& ec, std::size_t bytes_transferred = 0)
+        {
+            bool error_while_reading = true;
+            if (!ec)
+            {
+                read_end_ = offset + bytes_transferred;
+                bool ret = parse_pipelined([&] {
+                    return parser_.feed(buffer_.get() + offset, bytes_transferred);
+                });
+                if (ret && adaptor_.is_open())
+                {
+                    error_while_reading = false;
+                }
+            }
+
+            if (error_while_reading)
+            {
+                cancel_deadline_timer();
+                parser_.done();
+                adaptor_.shutdown_read();
+                adaptor_.close();
+                CROW_LOG_DEBUG << this << " from read(1) with description: \"" << http_errno_description(static_cast<http_errno>(parser_.http_errno)) << '\"';
+            }
+            else if (close_connection_)
+            {
+                cancel_deadline_timer();
+                parser_.done();
+                // adaptor will close after write
+            }
+            else if (!need_to_call_after_handlers_ && !is_writing_)
+            {
+                start_deadline();
+                do_read();
+            }
+            else
+            {
+                // res will be completed later by user, or is still being written
+                need_to_start_read_after_complete_ = true;
+            }
+        }
+
         void do_write()
         {
             auto self = this->shared_from_this();
@@ -11081,7 +13280,7 @@ namespace crow
               });
         }
 
-        inline void do_write_sync(std::vector<asio::const_buffer>& buffers)
+        inline bool do_write_sync(std::vector<asio::const_buffer>& buffers)
         {
             error_code ec;
             asio::write(adaptor_.socket(), buffers, ec);
@@ -11101,36 +13300,158 @@ namespace crow
             {
                 CROW_LOG_ERROR << ec << " - happened while sending buffers";
                 CROW_LOG_DEBUG << this << " from write (sync)(2)";
+                return false;
+            }
+            return true;
+        }
+
+        /// Run the parser over bytes that may hold several pipelined requests.
+        ///
+        /// Responses that are ready right away are batched meanwhile instead of written one by one, and go out together
+        /// once the parser runs out of complete requests, or in front of a response that is written asynchronously.
+        template<typename Parse>
+        bool parse_pipelined(Parse parse)
+        {
+            parsing_ = true;
+            bool ok = parse();
+            parsing_ = false;
+            if (!is_writing_)
+                flush_batch();
+            return ok;
+        }
+
+        /// Queue the response in buffers_ (its body being res_body_copy_ or its borrowed views) and be done with it.
+        void batch_response(std::function<void(std::size_t)> sent_handler)
+        {
+            std::string& head = batch_storage_.emplace_back();
+            head.reserve(asio::buffer_size(buffers_));
+            for (auto& buffer : buffers_)
+                head.append(static_cast<const char*>(buffer.data()), buffer.size());
+            batch_buffers_.emplace_back(head.data(), head.size());
+
+            std::size_t length = 0;
+            if (res.has_body_view())
+            {
+                if (!res.skip_body)
+                {
+                    for (auto& view : res.body_views_)
+                    {
+                        batch_buffers_.emplace_back(view.data, view.size);
+                        batch_owners_.push_back(view.owner);
+                        length += view.size;
+                    }
+                }
+            }
+            else if (!res_body_copy_.empty())
+            {
+                std::string& body = batch_storage_.emplace_back(std::move(res_body_copy_));
+                batch_buffers_.emplace_back(body.data(), body.size());
+                length = body.size();
+            }
+            if (sent_handler)
+                batch_sent_.emplace_back(std::move(sent_handler), length);
+
+            buffers_.clear();
+            res.clear();
+            res_body_copy_.clear();
+            if (continue_requested)
+                continue_requested = false;
+            else
+                parser_.clear();
+
+            // A deep pipeline doesn't grow a single write without bounds: the batch goes out as it is, and the parser
+            // waits for it before it handles the next request
+            if (batch_buffers_.size() >= max_batch_buffers)
+            {
+                parser_.pause();
+                flush_batch();
             }
         }
 
+        /// Put the batched responses in front of buffers_, they go out with the write that is about to start.
+        std::size_t take_batch()
+        {
+            std::size_t size = asio::buffer_size(batch_buffers_);
+            buffers_.insert(buffers_.begin(), batch_buffers_.begin(), batch_buffers_.end());
+            batch_buffers_.clear();
+            return size;
+        }
+
+        /// Let go of the batched responses once they are written (or failed to be).
+        void release_batch(bool sent)
+        {
+            batch_buffers_.clear();
+            batch_storage_.clear();
+            batch_owners_.clear();
+            auto handlers = std::move(batch_sent_);
+            batch_sent_.clear();
+            for (auto& handler : handlers)
+                handler.first(sent ? handler.second : 0);
+        }
+
+        /// Write the batched responses in one go, asynchronously: however small each one is there may be many of them, and a
+        /// slow client mustn't hold up the io_context thread.
+        void flush_batch()
+        {
+            if (batch_buffers_.empty())
+                return;
+
+            cancel_deadline_timer();
+            is_writing_ = true;
+            batch_writing_ = true;
+            buffers_.clear();
+            take_batch();
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), buffers_,
+              [self](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                  self->is_writing_ = false;
+                  self->batch_writing_ = false;
+                  self->buffers_.clear();
+                  self->release_batch(!ec);
+                  if (ec)
+                  {
+                      CROW_LOG_ERROR << ec << " - happened while sending buffers";
+                      self->close_connection_ = true;
+                  }
+                  if (self->close_connection_)
+                  {
+                      self->cancel_deadline_timer();
+                      self->adaptor_.shutdown_readwrite();
+                      self->adaptor_.close();
+                      return;
+                  }
+                  if (self->complete_after_batch_)
+                  {
+                      self->complete_after_batch_ = false;
+                      self->complete_request();
+                      if (self->is_writing_)
+                          return;
+                  }
+                  self->continue_pipeline();
+              });
+        }
+
         void cancel_deadline_timer()
         {
-            CROW_LOG_DEBUG << this << " timer cancelled: " << &task_timer_ << ' ' << task_id_;
-            task_timer_.cancel(task_id_);
+            CROW_LOG_DEBUG << this << " timer cancelled: " << &task_timer_;
+            task_timer_.cancel(deadline_);
         }
 
         void start_deadline(/*int timeout = 5*/)
         {
-            cancel_deadline_timer();
-
-            auto self = this->shared_from_this();
-            task_id_ = task_timer_.schedule([self] {
-                if (!self->adaptor_.is_open())
-                {
-                    return;
-                }
-                self->adaptor_.shutdown_readwrite();
-                self->adaptor_.close();
-            });
-            CROW_LOG_DEBUG << this << " timer added: " << &task_timer_ << ' ' << task_id_;
+            // Rescheduling replaces the previous deadline
+            task_timer_.schedule(deadline_);
+            CROW_LOG_DEBUG << this << " timer added: " << &task_timer_;
         }
 
     private:
         Adaptor adaptor_;
         Handler* handler_;
 
-        std::array<char, 4096> buffer_;
+        detail::read_buffer_pool::buffer buffer_; ///< Only held while a request is being read or handled.
+        std::size_t read_end_ = 0;                ///< End of the bytes the last read put into buffer_.
+        bool request_views_;
 
         HTTPParser<Connection> parser_;
         std::unique_ptr<routing_handle_result> routing_handle_result_;
@@ -11146,18 +13467,49 @@ namespace crow
         std::string date_str_;
         std::string res_body_copy_;
 
-        detail::task_timer::identifier_type task_id_{};
-
         bool continue_requested{};
         bool need_to_call_after_handlers_{};
         bool need_to_start_read_after_complete_{};
         bool add_keep_alive_{};
+        bool is_writing_{};
+        bool parsing_{}; ///< The parser is running over what was read, see parse_pipelined().
+
+        /// Batched buffers after which the batch is written, leaving room below IOV_MAX (1024 on Linux) for the headers of a
+        /// response it goes out in front of.
+        static constexpr std::size_t max_batch_buffers = 512;
+        std::vector<asio::const_buffer> batch_buffers_; ///< Batched responses not yet handed to a write.
+        std::deque<std::string> batch_storage_;         ///< Their headers and string bodies, elements never move.
+        std::vector<std::shared_ptr<const void>> batch_owners_;
+        std::vector<std::pair<std::function<void(std::size_t)>, std::size_t>> batch_sent_; ///< Sent handlers and body lengths.
+        bool batch_writing_{};        ///< flush_batch() is writing the batch.
+        bool complete_after_batch_{}; ///< A response was completed meanwhile, it is sent once the batch is out.
+
+        std::size_t body_bytes_sent_ = 0;
+        std::shared_ptr<body_source> body_source_;
+        bool source_chunked_{};
+        bool source_headers_pending_{};
+        std::string chunk_header_;
+
+#ifdef CROW_HAS_SENDFILE
+        int static_fd_ = -1;
+        std::vector<iovec> file_iov_;
+        std::vector<asio::const_buffer> file_prefix_;
+#ifdef CROW_HAS_FILE_CACHE
+        std::shared_ptr<const open_file> static_file_;
+#endif
+        off_t static_offset_ = 0;
+        off_t static_end_ = 0;
+        int pipe_fds_[2] = {-1, -1};
+        std::size_t pipe_fill_ = 0;
+        std::size_t static_part_ = 0;
+#endif
 
         std::tuple<Middlewares...>* middlewares_;
         detail::context<Middlewares...> ctx_;
 
         std::function<std::string()>& get_cached_date_str;
         detail::task_timer& task_timer_;
+        detail::task_timer::entry deadline_; ///< Closes the connection when it runs, cancelled when the connection goes away.
 
         size_t res_stream_threshold_;
 
@@ -11189,6 +13541,13 @@ namespace crow
 #include <memory>
 #include <thread>
 #include <vector>
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/filter.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 
 
@@ -11203,6 +13562,124 @@ namespace crow // NOTE: Already documented in "crow/app.h"
     using tcp = asio::ip::tcp;
     using stream_protocol = asio::local::stream_protocol;
 
+#ifdef __linux__
+    /// The CPUs the process may run on and the NUMA node each of them belongs to, read once from sysfs.
+    ///
+    /// The CPU list is the affinity mask of the thread that first asks for the topology, so ask before pinning anything.
+    /// Without NUMA information every CPU is on node 0.
+    class cpu_topology
+    {
+    public:
+        static const cpu_topology& instance()
+        {
+            static cpu_topology topology;
+            return topology;
+        }
+
+        /// Usable CPUs in ascending order.
+        const std::vector<int>& cpus() const
+        {
+            return cpus_;
+        }
+
+        /// Number of nodes, nodes are numbered from 0.
+        int node_count() const
+        {
+            return static_cast<int>(node_cpus_.size());
+        }
+
+        /// Usable CPUs of a node, may be empty.
+        const std::vector<int>& node_cpus(int node) const
+        {
+            return node_cpus_[node];
+        }
+
+        /// The node of a CPU.
+        int node_of(int cpu) const
+        {
+            auto it = std::find(cpus_.begin(), cpus_.end(), cpu);
+            return it == cpus_.end() ? 0 : cpu_nodes_[it - cpus_.begin()];
+        }
+
+        /// The node the calling thread runs on at the moment, which for an unpinned thread may change any time.
+        int current_node() const
+        {
+            unsigned cpu = 0, node = 0;
+            if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || static_cast<int>(node) >= node_count())
+                return 0;
+            return static_cast<int>(node);
+        }
+
+        /// Keep the calling thread on one CPU.
+        bool pin(int cpu) const
+        {
+            return pin(std::vector<int>{cpu});
+        }
+
+        /// Keep the calling thread on the CPUs of a node.
+        bool pin_to_node(int node) const
+        {
+            return node >= 0 && node < node_count() && pin(node_cpus_[node]);
+        }
+
+    private:
+        cpu_topology()
+        {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            sched_getaffinity(0, sizeof(allowed), &allowed);
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (!CPU_ISSET(cpu, &allowed))
+                    continue;
+                int node = read_node(cpu);
+                cpus_.push_back(cpu);
+                cpu_nodes_.push_back(node);
+                if (node >= node_count())
+                    node_cpus_.resize(node + 1);
+                node_cpus_[node].push_back(cpu);
+            }
+            if (node_cpus_.empty())
+                node_cpus_.resize(1);
+        }
+
+        // A CPU's directory has a "nodeN" link to its node
+        static int read_node(int cpu)
+        {
+            std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+            DIR* dir = opendir(path.c_str());
+            if (!dir)
+                return 0;
+            int node = 0;
+            while (dirent* entry = readdir(dir))
+            {
+                if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(static_cast<unsigned char>(entry->d_name[4])))
+                {
+                    node = atoi(entry->d_name + 4);
+                    break;
+                }
+            }
+            closedir(dir);
+            return node;
+        }
+
+        static bool pin(const std::vector<int>& cpus)
+        {
+            if (cpus.empty())
+                return false;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus)
+                CPU_SET(cpu, &set);
+            return sched_setaffinity(0, sizeof(set), &set) == 0;
+        }
+
+        std::vector<int> cpus_;
+        std::vector<int> cpu_nodes_;               ///< Node of each of cpus_.
+        std::vector<std::vector<int>> node_cpus_;
+    };
+#endif
+
     template<typename Handler, typename Acceptor = TCPAcceptor, typename Adaptor = SocketAdaptor, typename... Middlewares>
     class Server
     {
@@ -11246,6 +13723,20 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 return;
             }
 
+            if constexpr (Acceptor::supports_reuse_port)
+            {
+                if (handler_->reuse_port_enabled() && concurrency_ > 1)
+                {
+                    acceptor_.raw_acceptor().set_option(typename Acceptor::reuse_port(true), ec);
+                    if (ec)
+                    {
+                        CROW_LOG_WARNING << "SO_REUSEPORT not available, accepting on one thread: " << ec.message();
+                    }
+                    else
+                        reuse_port_ = true;
+                }
+            }
+
             acceptor_.raw_acceptor().bind(endpoint, ec);
             if (ec) {
                 CROW_LOG_ERROR << "Failed to bind to " << acceptor_.address()
@@ -11254,14 +13745,12 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 return;
             }
 
-            acceptor_.raw_acceptor().listen(tcp::acceptor::max_listen_connections, ec);
-            if (ec) {
-                CROW_LOG_ERROR << "Failed to listen on port: " << ec.message();
-                startup_failed_ = true;
+            // With SO_REUSEPORT this socket only holds on to the port (and resolves port 0), the workers listen on their own
+            if (reuse_port_)
                 return;
-            }
-
 
+            if (!listen())
+                startup_failed_ = true;
         }
 
         void set_tick_function(std::chrono::milliseconds d, std::function<void()> f)
@@ -11290,17 +13779,36 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             }
 
             uint16_t worker_thread_count = concurrency_ - 1;
-            for (int i = 0; i < worker_thread_count; i++)
-                io_context_pool_.emplace_back(new asio::io_context());
+            // Each worker creates its own io_context
+            io_context_pool_.resize(worker_thread_count);
             get_cached_date_str_pool_.resize(worker_thread_count);
             task_timer_pool_.resize(worker_thread_count);
+            connection_pool_.clear();
+            for (uint16_t i = 0; i < worker_thread_count; i++)
+                connection_pool_.emplace_back(std::make_shared<detail::block_pool>(CROW_CONNECTION_POOL_SIZE));
+
+            bool pin_workers = handler_->pin_workers_enabled();
+#ifdef __linux__
+            if (pin_workers)
+                cpu_topology::instance(); // before any thread is pinned
+#endif
 
             std::vector<std::future<void>> v;
             std::atomic<int> init_count(0);
             for (uint16_t i = 0; i < worker_thread_count; i++)
                 v.push_back(
                   std::async(
-                    std::launch::async, [this, i, &init_count] {
+                    std::launch::async, [this, i, pin_workers, &init_count] {
+#ifdef __linux__
+                        // Pinned before the thread allocates anything, so that its io_context, timers and the connections it
+                        // accepts end up in memory of its own NUMA node (first touch)
+                        if (pin_workers)
+                            pin_worker(i);
+#else
+                        (void)pin_workers;
+#endif
+                        io_context_pool_[i].reset(new asio::io_context());
+
                         // thread local date string get function
                         auto last = std::chrono::steady_clock::now();
 
@@ -11334,6 +13842,9 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                         task_timer_pool_[i] = &task_timer;
                         task_queue_length_pool_[i] = 0;
 
+                        // The task timer only waits while something is scheduled, keep run() from returning while idle
+                        auto work = asio::make_work_guard(*io_context_pool_[i]);
+
                         init_count++;
                         while (1)
                         {
@@ -11377,7 +13888,22 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             while (worker_thread_count != init_count)
                 std::this_thread::yield();
 
-            do_accept();
+            if (reuse_port_ && open_worker_acceptors())
+            {
+                for (uint16_t i = 0; i < worker_thread_count; i++)
+                    asio::post(*io_context_pool_[i], [this, i] {
+                        do_accept_on(i);
+                    });
+            }
+            else
+            {
+                if (reuse_port_ && !listen())
+                {
+                    stop();
+                    return;
+                }
+                do_accept();
+            }
 
             std::thread(
               [this] {
@@ -11386,6 +13912,12 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                   CROW_LOG_INFO << "Exiting.";
               })
               .join();
+
+            // Once the workers are done nothing accepts on their sockets anymore, close them so they
+            // don't keep taking connections for a server that is gone
+            for (auto& worker : v)
+                worker.wait();
+            worker_acceptors_.clear();
         }
 
         void stop()
@@ -11406,6 +13938,16 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 }
             }
 
+            for (std::size_t i = 0; i < worker_acceptors_.size(); i++)
+            {
+                // Owned by the worker's thread, close it there
+                auto* acceptor = worker_acceptors_[i].get();
+                asio::post(*io_context_pool_[i], [acceptor] {
+                    error_code ec;
+                    acceptor->raw_acceptor().close(ec);
+                });
+            }
+
             for (auto& io_context : io_context_pool_)
             {
                 if (io_context != nullptr)
@@ -11447,6 +13989,29 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         }
 
     private:
+#ifdef __linux__
+        /// The CPU worker `idx` is pinned to: the idx-th usable CPU, round robin when there are more workers than CPUs. -1 without any.
+        static int worker_cpu(uint16_t idx)
+        {
+            const std::vector<int>& cpus = cpu_topology::instance().cpus();
+            return cpus.empty() ? -1 : cpus[idx % cpus.size()];
+        }
+
+        void pin_worker(uint16_t idx)
+        {
+            const cpu_topology& topology = cpu_topology::instance();
+            int cpu = worker_cpu(idx);
+            if (cpu < 0)
+                return;
+            if (topology.pin(cpu))
+            {
+                CROW_LOG_DEBUG << "Worker " << idx << " pinned to CPU " << cpu << " (node " << topology.node_of(cpu) << ")";
+            }
+            else
+                CROW_LOG_WARNING << "Could not pin worker " << idx << " to CPU " << cpu << ": " << strerror(errno);
+        }
+#endif
+
         size_t pick_io_context_idx()
         {
             size_t min_queue_idx = 0;
@@ -11463,13 +14028,132 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             return min_queue_idx;
         }
 
+        bool listen()
+        {
+            error_code ec;
+            acceptor_.raw_acceptor().listen(tcp::acceptor::max_listen_connections, ec);
+            if (ec)
+                CROW_LOG_ERROR << "Failed to listen on port: " << ec.message();
+            return !ec;
+        }
+
+        /// Give every worker a listening socket of its own on the endpoint, the kernel spreads new connections across them.
+        bool open_worker_acceptors()
+        {
+            if constexpr (Acceptor::supports_reuse_port)
+            {
+                auto endpoint = acceptor_.local_endpoint();
+                for (auto& io_context : io_context_pool_)
+                {
+                    std::unique_ptr<Acceptor> acceptor(new Acceptor(*io_context));
+                    error_code ec;
+                    acceptor->raw_acceptor().open(endpoint.protocol(), ec);
+                    if (!ec)
+                        acceptor->raw_acceptor().set_option(Acceptor::reuse_address_option(), ec);
+                    if (!ec)
+                        acceptor->raw_acceptor().set_option(typename Acceptor::reuse_port(true), ec);
+                    if (!ec)
+                        acceptor->raw_acceptor().bind(endpoint, ec);
+                    if (!ec)
+                        acceptor->raw_acceptor().listen(tcp::acceptor::max_listen_connections, ec);
+                    if (ec)
+                    {
+                        CROW_LOG_WARNING << "Failed to open a SO_REUSEPORT acceptor, accepting on one thread: " << ec.message();
+                        worker_acceptors_.clear();
+                        return false;
+                    }
+                    worker_acceptors_.push_back(std::move(acceptor));
+                }
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+                if (handler_->reuse_port_steering())
+                    attach_steering_program();
+#endif
+                CROW_LOG_INFO << "Accepting on " << worker_acceptors_.size() << " SO_REUSEPORT sockets";
+                return true;
+            }
+            return false;
+        }
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+        /// Hand each connection to the worker pinned to the CPU that took the packet. The program is built from the same CPU to worker
+        /// table pin_worker() uses, as one comparison per CPU: sockets are picked in the order they were bound, which is worker order.
+        /// A CPU without a worker of its own returns an out of range index, the kernel then picks a socket by hash as it would without
+        /// a program.
+        void attach_steering_program()
+        {
+            if (!handler_->pin_workers_enabled())
+            {
+                CROW_LOG_WARNING << "Not steering connections by CPU, the workers aren't pinned";
+                return;
+            }
+
+            std::vector<sock_filter> code;
+            code.push_back({BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)});
+            std::vector<int> steered;
+            for (uint16_t idx = 0; idx < worker_acceptors_.size(); idx++)
+            {
+                int cpu = worker_cpu(idx);
+                if (cpu < 0 || std::find(steered.begin(), steered.end(), cpu) != steered.end())
+                    continue; // more workers than CPUs, the first one on a CPU gets its connections
+                steered.push_back(cpu);
+                code.push_back({BPF_JMP | BPF_JEQ | BPF_K, 0, 1, static_cast<uint32_t>(cpu)});
+                code.push_back({BPF_RET | BPF_K, 0, 0, idx});
+            }
+            code.push_back({BPF_RET | BPF_K, 0, 0, 0xFFFFFFFF});
+            if (code.size() > BPF_MAXINSNS)
+            {
+                CROW_LOG_WARNING << "Not steering connections by CPU, " << steered.size() << " CPUs don't fit in one program";
+                return;
+            }
+
+            std::size_t usable = cpu_topology::instance().cpus().size();
+            if (steered.size() < usable)
+                CROW_LOG_INFO << "Steering connections of " << steered.size() << " of " << usable << " CPUs, the other CPUs have no worker and are hashed";
+
+            sock_fprog program = {static_cast<unsigned short>(code.size()), code.data()};
+            if (setsockopt(worker_acceptors_[0]->raw_acceptor().native_handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) != 0)
+                CROW_LOG_WARNING << "Could not attach the CPU steering program: " << strerror(errno);
+        }
+#endif
+
+        /// A connection for worker `idx`, in memory a connection of that worker left behind if there is any.
+        template<typename... Args>
+        std::shared_ptr<Connection<Adaptor, Handler, Middlewares...>> make_connection(size_t idx, Args&&... args)
+        {
+            using connection_t = Connection<Adaptor, Handler, Middlewares...>;
+            return std::allocate_shared<connection_t>(detail::pool_allocator<connection_t>(connection_pool_[idx]), std::forward<Args>(args)...);
+        }
+
+        /// Accept on worker `idx`'s own socket and serve the connection right there, on the thread that accepted it.
+        void do_accept_on(size_t idx)
+        {
+            if (shutting_down_)
+                return;
+
+            asio::io_context& ic = *io_context_pool_[idx];
+            auto p = make_connection(idx,
+              ic, handler_, server_name_, middlewares_,
+              get_cached_date_str_pool_[idx], *task_timer_pool_[idx], adaptor_ctx_, task_queue_length_pool_[idx]);
+
+            worker_acceptors_[idx]->raw_acceptor().async_accept(
+              p->socket(),
+              [this, p, idx](error_code ec) {
+                  if (ec == asio::error::operation_aborted)
+                      return;
+                  if (!ec)
+                      p->start();
+                  do_accept_on(idx);
+              });
+        }
+
         void do_accept()
         {
             if (!shutting_down_)
             {
                 size_t context_idx = pick_io_context_idx();
                 asio::io_context& ic = *io_context_pool_[context_idx];
-                auto p = std::make_shared<Connection<Adaptor, Handler, Middlewares...>>(
+                auto p = make_connection(context_idx,
                     ic, handler_, server_name_, middlewares_,
                     get_cached_date_str_pool_[context_idx], *task_timer_pool_[context_idx], adaptor_ctx_, task_queue_length_pool_[context_idx]);
                     
@@ -11504,9 +14188,12 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         std::vector<std::unique_ptr<asio::io_context>> io_context_pool_;
         asio::io_context io_context_;
         std::vector<detail::task_timer*> task_timer_pool_;
+        std::vector<std::shared_ptr<detail::block_pool>> connection_pool_; ///< Memory of closed connections, per worker.
         std::vector<std::function<std::string()>> get_cached_date_str_pool_;
         Acceptor acceptor_;
-        bool shutting_down_ = false;
+        bool reuse_port_ = false;
+        std::vector<std::unique_ptr<Acceptor>> worker_acceptors_; ///< One per worker with SO_REUSEPORT.
+        std::atomic<bool> shutting_down_{false};
         bool server_started_{false};
         bool startup_failed_ = false;
         std::condition_variable cv_started_;
@@ -13087,6 +15774,94 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
     const int RULE_SPECIAL_REDIRECT_SLASH = 1;
 
+    /// The URLs a trie matches without any parameter, each with what the trie finds for it.
+    ///
+    /// Built once the routes are known. The seed of the hash is picked so that no two URLs share a slot (a perfect hash),
+    /// a lookup is one hash and at most one comparison. Any other URL isn't in the table and goes through the trie.
+    class exact_route_table
+    {
+    public:
+        /// Fill the table with `urls`, `resolve` giving the result for each. Results may point into the URL they are for.
+        template<typename Resolve>
+        void build(std::vector<std::string> urls, Resolve resolve)
+        {
+            clear();
+            if (urls.empty())
+                return;
+
+            // Reserved up front, the results point into these strings
+            entries_.reserve(urls.size());
+            for (auto& url : urls)
+                entries_.push_back({std::move(url), routing_handle_result()});
+            for (auto& entry : entries_)
+                entry.result = resolve(std::string_view(entry.url));
+
+            std::size_t size = 1;
+            while (size < entries_.size() * 2)
+                size <<= 1;
+            for (;; size <<= 1)
+            {
+                for (seed_ = 1; seed_ <= 32; seed_++)
+                {
+                    if (place(size))
+                        return;
+                }
+            }
+        }
+
+        const routing_handle_result* find(std::string_view url) const
+        {
+            if (slots_.empty())
+                return nullptr;
+            uint16_t slot = slots_[hash(url, seed_) & (slots_.size() - 1)];
+            if (!slot || entries_[slot - 1].url != url)
+                return nullptr;
+            return &entries_[slot - 1].result;
+        }
+
+        void clear()
+        {
+            entries_.clear();
+            slots_.clear();
+        }
+
+    private:
+        struct entry
+        {
+            std::string url;
+            routing_handle_result result;
+        };
+
+        static uint64_t hash(std::string_view url, uint64_t seed)
+        {
+            // FNV-1a
+            uint64_t h = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+            for (char c : url)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 1099511628211ull;
+            }
+            return h ^ (h >> 29);
+        }
+
+        bool place(std::size_t size)
+        {
+            slots_.assign(size, 0);
+            for (std::size_t i = 0; i < entries_.size(); i++)
+            {
+                uint16_t& slot = slots_[hash(entries_[i].url, seed_) & (size - 1)];
+                if (slot)
+                    return false;
+                slot = static_cast<uint16_t>(i + 1);
+            }
+            return true;
+        }
+
+        std::vector<entry> entries_;
+        std::vector<uint16_t> slots_; ///< 1 + the index of the entry in each slot, 0 if empty.
+        uint64_t seed_ = 0;
+    };
+
 
     /// A search tree.
     class Trie
@@ -13216,10 +15991,18 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             if (!head_.IsSimpleNode())
                 throw std::runtime_error("Internal error: Trie header should be simple!");
             optimize();
+
+            // URLs without parameters skip the tree walk from now on
+            std::vector<std::string> urls;
+            std::string url;
+            collect_literal_urls(head_, url, urls);
+            exact_.build(std::move(urls), [this](std::string_view literal) {
+                return find(literal, head_);
+            });
         }
 
         //Rule_index, Blueprint_index, routing_params
-        routing_handle_result find(const std::string& req_url, const Node& node, unsigned pos = 0, routing_params* params = nullptr, std::vector<uint16_t>* blueprints = nullptr) const
+        routing_handle_result find(std::string_view req_url, const Node& node, unsigned pos = 0, routing_params* params = nullptr, std::vector<uint16_t>* blueprints = nullptr) const
         {
             //start params as an empty struct
             routing_params empty;
@@ -13264,7 +16047,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                             char* eptr;
                             errno = 0;
                             long long int value = strtoll(req_url.data() + pos, &eptr, 10);
-                            if (errno != ERANGE && eptr != req_url.data() + pos)
+                            if (errno != ERANGE && eptr != req_url.data() + pos && eptr <= req_url.data() + req_url.size())
                             {
                                 found_fragment = true;
                                 params->int_params.push_back(value);
@@ -13285,7 +16068,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                             char* eptr;
                             errno = 0;
                             unsigned long long int value = strtoull(req_url.data() + pos, &eptr, 10);
-                            if (errno != ERANGE && eptr != req_url.data() + pos)
+                            if (errno != ERANGE && eptr != req_url.data() + pos && eptr <= req_url.data() + req_url.size())
                             {
                                 found_fragment = true;
                                 params->uint_params.push_back(value);
@@ -13306,7 +16089,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                             char* eptr;
                             errno = 0;
                             double value = strtod(req_url.data() + pos, &eptr);
-                            if (errno != ERANGE && eptr != req_url.data() + pos)
+                            if (errno != ERANGE && eptr != req_url.data() + pos && eptr <= req_url.data() + req_url.size())
                             {
                                 found_fragment = true;
                                 params->double_params.push_back(value);
@@ -13331,7 +16114,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                         if (epos != pos)
                         {
                             found_fragment = true;
-                            params->string_params.push_back(req_url.substr(pos, epos - pos));
+                            params->string_params.emplace_back(req_url.substr(pos, epos - pos));
                             if (child.blueprint_index != INVALID_BP_ID) blueprints->push_back(child.blueprint_index);
                             auto ret = find(req_url, child, epos, params, blueprints);
                             update_found(ret);
@@ -13347,7 +16130,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                         if (epos != pos)
                         {
                             found_fragment = true;
-                            params->string_params.push_back(req_url.substr(pos, epos - pos));
+                            params->string_params.emplace_back(req_url.substr(pos, epos - pos));
                             if (child.blueprint_index != INVALID_BP_ID) blueprints->push_back(child.blueprint_index);
                             auto ret = find(req_url, child, epos, params, blueprints);
                             update_found(ret);
@@ -13377,14 +16160,18 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             return routing_handle_result{found, found_BP, match_params}; //Called after all the recursions have been done
         }
 
-        routing_handle_result find(const std::string& req_url) const
+        routing_handle_result find(std::string_view req_url) const
         {
+            if (const routing_handle_result* exact = exact_.find(req_url))
+                return *exact;
             return find(req_url, head_);
         }
 
         //This functions assumes any blueprint info passed is valid
         void add(const std::string& url, uint16_t rule_index, unsigned bp_prefix_length = 0, uint16_t blueprint_index = INVALID_BP_ID)
         {
+            // Filled again by validate()
+            exact_.clear();
             auto idx = &head_;
 
             bool has_blueprint = bp_prefix_length != 0 && blueprint_index != INVALID_BP_ID;
@@ -13469,7 +16256,23 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         }
 
     private:
+        /// Every URL that reaches a rule through literal keys only.
+        static void collect_literal_urls(const Node& node, std::string& url, std::vector<std::string>& urls)
+        {
+            if (node.rule_index)
+                urls.push_back(url);
+            for (const auto& child : node.children)
+            {
+                if (child.param != ParamType::MAX)
+                    continue;
+                url += child.key;
+                collect_literal_urls(child, url, urls);
+                url.resize(url.size() - child.key.size());
+            }
+        }
+
         Node head_;
+        exact_route_table exact_;
     };
 
     /// A blueprint can be considered a smaller section of a Crow app, specifically where the router is concerned.
@@ -13801,22 +16604,22 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
             auto& per_method = per_methods_[static_cast<int>(req.method)];
             auto& rules = per_method.rules;
-            unsigned rule_index = per_method.trie.find(req.url).rule_index;
+            unsigned rule_index = per_method.trie.find(req.url_view()).rule_index;
 
             if (!rule_index)
             {
                 for (auto& method : per_methods_)
                 {
-                    if (method.trie.find(req.url).rule_index)
+                    if (method.trie.find(req.url_view()).rule_index)
                     {
-                        CROW_LOG_DEBUG << "Cannot match method " << req.url << " " << method_name(req.method);
+                        CROW_LOG_DEBUG << "Cannot match method " << req.url_view() << " " << method_name(req.method);
                         res = response(405);
                         res.end();
                         return;
                     }
                 }
 
-                CROW_LOG_INFO << "Cannot match rules " << req.url;
+                CROW_LOG_INFO << "Cannot match rules " << req.url_view();
                 res = response(404);
                 res.end();
                 return;
@@ -13827,9 +16630,9 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
             if (rule_index == RULE_SPECIAL_REDIRECT_SLASH)
             {
-                CROW_LOG_INFO << "Redirecting to a url with trailing slash: " << req.url;
+                CROW_LOG_INFO << "Redirecting to a url with trailing slash: " << req.url_view();
                 res = response(301);
-                res.add_header("Location", req.url + "/");
+                res.add_header("Location", std::string(req.url_view()) + "/");
                 res.end();
                 return;
             }
@@ -13949,15 +16752,15 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 return found;
             else if (req.method == HTTPMethod::Head)
             {
-                *found = per_methods_[static_cast<int>(method_actual)].trie.find(req.url);
+                *found = per_methods_[static_cast<int>(method_actual)].trie.find(req.url_view());
                 // support HEAD requests using GET if not defined as method for the requested URL
                 if (!found->rule_index)
                 {
                     method_actual = HTTPMethod::Get;
-                    *found = per_methods_[static_cast<int>(method_actual)].trie.find(req.url);
+                    *found = per_methods_[static_cast<int>(method_actual)].trie.find(req.url_view());
                     if (!found->rule_index) // If a route is still not found, return a 404 without executing the rest of the HEAD specific code.
                     {
-                        CROW_LOG_DEBUG << "Cannot match rules " << req.url;
+                        CROW_LOG_DEBUG << "Cannot match rules " << req.url_view();
                         res = response(404); //TODO(EDev): Should this redirect to catchall?
                         res.end();
                         return found;
@@ -13972,7 +16775,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             {
                 std::string allow = "OPTIONS, HEAD";
 
-                if (req.url == "/*")
+                if (req.url_view() == "/*")
                 {
                     for (int i = 0; i < static_cast<int>(HTTPMethod::InternalMethodCount); i++)
                     {
@@ -14001,7 +16804,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                     bool rules_matched = false;
                     for (int i = 0; i < static_cast<int>(HTTPMethod::InternalMethodCount); i++)
                     {
-                        if (per_methods_[i].trie.find(req.url).rule_index)
+                        if (per_methods_[i].trie.find(req.url_view()).rule_index)
                         {
                             rules_matched = true;
 
@@ -14026,7 +16829,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                     }
                     else
                     {
-                        CROW_LOG_DEBUG << "Cannot match rules " << req.url;
+                        CROW_LOG_DEBUG << "Cannot match rules " << req.url_view();
                         res = response(404); //TODO(EDev): Should this redirect to catchall?
                         res.end();
                         return found;
@@ -14035,17 +16838,17 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             }
             else // Every request that isn't a HEAD or OPTIONS request
             {
-                *found = per_methods_[static_cast<int>(method_actual)].trie.find(req.url);
+                *found = per_methods_[static_cast<int>(method_actual)].trie.find(req.url_view());
                 // TODO(EDev): maybe ending the else here would allow the requests coming from above (after removing the return statement) to be checked on whether they actually point to a route
                 if (!found->rule_index)
                 {
                     for (auto& per_method : per_methods_)
                     {
-                        if (per_method.trie.find(req.url).rule_index) //Route found, but in another method
+                        if (per_method.trie.find(req.url_view()).rule_index) //Route found, but in another method
                         {
                             res.code = 405;
                             found->catch_all = true;
-                            CROW_LOG_DEBUG << "Cannot match method " << req.url << " "
+                            CROW_LOG_DEBUG << "Cannot match method " << req.url_view() << " "
                                            << method_name(method_actual) << ". " << get_error(*found);
                             return found;
                         }
@@ -14054,7 +16857,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
                     res.code = 404;
                     found->catch_all = true;
-                    CROW_LOG_DEBUG << "Cannot match rules " << req.url << ". " << get_error(*found);
+                    CROW_LOG_DEBUG << "Cannot match rules " << req.url_view() << ". " << get_error(*found);
                     return found;
                 }
 
@@ -14087,9 +16890,9 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 if (rule_index >= rules.size())
                     throw std::runtime_error("Trie internal structure corrupted!");
                 if (rule_index == RULE_SPECIAL_REDIRECT_SLASH) {
-                    CROW_LOG_INFO << "Redirecting to a url with trailing slash: " << req.url;
+                    CROW_LOG_INFO << "Redirecting to a url with trailing slash: " << req.url_view();
                     res = response(301);
-                    res.add_header("Location", req.url + "/");
+                    res.add_header("Location", std::string(req.url_view()) + "/");
                     res.end();
                 } else {
                     CROW_LOG_DEBUG << "Matched rule '" << rules[rule_index]->rule_ << "' " << static_cast<uint32_t>(req.
@@ -14349,7 +17152,7 @@ namespace crow
                     set_header_no_override("Access-Control-Allow-Credentials", "true", res);
                     if (origin_ == "*")
                     {
-                        set_header_no_override("Access-Control-Allow-Origin", req.get_header_value("Origin"), res);
+                        set_header_no_override("Access-Control-Allow-Origin", std::string(req.get_header_view("Origin")), res);
                         origin_set = true;
                     }
                 }
@@ -14388,7 +17191,7 @@ namespace crow
 
         void after_handle(crow::request& req, crow::response& res, context& /*ctx*/)
         {
-            auto& rule = find_rule(req.url);
+            auto& rule = find_rule(req.url_view());
             rule.apply(req, res);
         }
 
@@ -14413,7 +17216,7 @@ namespace crow
         }
 
     private:
-        CORSRules& find_rule(const std::string& path)
+        CORSRules& find_rule(std::string_view path)
         {
             // TODO: use a trie in case of many rules
             for (auto& rule : rules)
@@ -14833,6 +17636,49 @@ namespace crow
             return concurrency_;
         }
 
+        /// \brief Give every worker thread a listening socket of its own (SO_REUSEPORT) instead of accepting every connection on one thread
+        ///
+        /// The kernel spreads new connections over the sockets and each worker serves what it accepted, so there's neither a single accepting
+        /// thread nor a handoff between threads for every connection. With `steer_by_cpu` (Linux) a connection goes to the worker pinned to
+        /// the CPU that received it; it needs \ref pin_workers(), and connections of CPUs without a worker are spread as usual.
+        /// Falls back to a single acceptor where SO_REUSEPORT isn't available.
+        self_t& reuse_port(bool steer_by_cpu = false)
+        {
+            reuse_port_ = true;
+            reuse_port_steering_ = steer_by_cpu;
+            return *this;
+        }
+
+        /// \brief Get whether every worker thread accepts on its own socket
+        bool reuse_port_enabled() const
+        {
+            return reuse_port_;
+        }
+
+        /// \brief Get whether connections are steered to the worker of the CPU that received them
+        bool reuse_port_steering() const
+        {
+            return reuse_port_steering_;
+        }
+
+        /// \brief Pin every worker thread to a CPU of its own (Linux)
+        ///
+        /// Worker i runs on the i-th CPU the process may use. Each worker creates its io_context and timers after it was pinned,
+        /// so they live in memory of the worker's NUMA node, and so do the connections it accepts with \ref reuse_port() (without
+        /// it connections are created by the accepting thread). `reuse_port(true)` then keeps every connection on the CPU, and
+        /// node, that received it. Use `cpu_topology::current_node()` to keep per-node data in handlers.
+        self_t& pin_workers()
+        {
+            pin_workers_ = true;
+            return *this;
+        }
+
+        /// \brief Get whether worker threads are pinned to CPUs
+        bool pin_workers_enabled() const
+        {
+            return pin_workers_;
+        }
+
         /// \brief Set the server's log level
         ///
         /// Possible values are:
@@ -14915,6 +17761,37 @@ namespace crow
         }
 #endif
 
+        /// \brief Serve `<file>.br` / `<file>.gz` next to a static file to clients that accept that encoding
+        ///
+        /// The copies are produced ahead of time (`gzip -k`, `brotli -k`), so nothing is compressed on the request path
+        /// and the copy goes out with sendfile like the file would. Works without CROW_ENABLE_COMPRESSION.
+        self_t& use_precompressed()
+        {
+            precompressed_used_ = true;
+            return *this;
+        }
+
+        bool precompressed_used() const
+        {
+            return precompressed_used_;
+        }
+
+        /// \brief Parse requests into string_views over the connection's read buffer instead of copying them
+        ///
+        /// The URL, query and headers end up in \ref request::views and `raw_url`, `url`, `url_params` and `headers` stay
+        /// empty, so a request without a body is parsed without allocating. A handler that needs those members or keeps
+        /// the request beyond its response uses \ref request::owned().
+        self_t& use_request_views()
+        {
+            request_views_used_ = true;
+            return *this;
+        }
+
+        bool request_views_used() const
+        {
+            return request_views_used_;
+        }
+
         /// \brief Apply blueprints
         void add_blueprint()
         {
@@ -15251,6 +18128,9 @@ namespace crow
         std::uint8_t timeout_{5};
         uint16_t port_ = 80;
         unsigned int concurrency_ = 2;
+        bool reuse_port_ = false;
+        bool reuse_port_steering_ = false;
+        bool pin_workers_ = false;
         std::atomic_bool is_bound_ = false;
         uint64_t max_payload_{UINT64_MAX};
         std::string server_name_ = std::string("Crow/") + VERSION;
@@ -15264,6 +18144,8 @@ namespace crow
         compression::algorithm comp_algorithm_;
         bool compression_used_{false};
 #endif
+        bool precompressed_used_{false};
+        bool request_views_used_{false};
 
         std::chrono::milliseconds tick_interval_;
         std::function<void()> tick_function_;
@@ -0,0 +1,631 @@
+#pragma once
+
+// HLS view of a media directory.
+//
+// Every MPEG-TS file directly in the directory is one rendition, cut into
+// segments by byte offset. Each segment starts at the first keyframe (a video
+// packet with the random access indicator set) after about the target
+// duration at the file's bitrate, so it can be decoded and seeked to on its
+// own. When the muxer repeated PAT and PMT right before that keyframe the cut
+// is moved back to them; otherwise the segment carries a copy of the file's
+// PAT and PMT packets to send first. The bitrate comes from the PCR
+// timestamps at both ends of the file, or a fallback when there are none.
+// Every subdirectory holding .ts files is a rendition of pre-cut segments, one
+// per file, in numeric order. Nothing is rewritten to disk: a segment is just
+// (path, offset, length) and maybe its header, ready to be sent with sendfile.
+//
+// Playlists are generated once and kept in memory. Requests revalidate them
+// against the directory and file stat, and only what changed is redone: a
+// growing recording keeps its finished segments and is only cut further, new
+// pre-cut files are probed while known ones are reused, and the master
+// playlist is only rebuilt when the set of renditions changes. Files are read
+// without holding the index lock, a rendition being probed only holds up
+// other refreshes of that same rendition.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class HlsIndex {
+public:
+    using Playlist = std::shared_ptr<const std::string>;
+
+    struct Segment {
+        std::string path;
+        uint64_t offset;
+        uint64_t length;
+        double duration;
+        // PAT and PMT packets to send before the segment's bytes, set when
+        // the cut doesn't start with them
+        std::shared_ptr<const std::string> header;
+    };
+
+    HlsIndex(std::string media_dir, double target_duration = 4.0,
+             uint64_t fallback_bitrate = 5000000)
+        : media_dir_(std::move(media_dir)),
+          target_duration_(target_duration),
+          fallback_bitrate_(fallback_bitrate) {}
+
+    HlsIndex(const HlsIndex&) = delete;
+    HlsIndex& operator=(const HlsIndex&) = delete;
+
+    // nullptr when the media directory can't be read
+    Playlist master_playlist() {
+        std::vector<std::shared_ptr<Rendition>> renditions;
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!refresh_directory()) return nullptr;
+            if (master_) return master_;
+            for (auto& rendition : renditions_) renditions.push_back(rendition.second);
+            generation = generation_;
+        }
+
+        Playlist playlist = build_master(renditions);
+        std::lock_guard<std::mutex> lock(mutex_);
+        // A rendition changed its bitrate meanwhile, the next request rebuilds
+        if (generation == generation_) master_ = playlist;
+        return playlist;
+    }
+
+    // nullptr for an unknown rendition
+    Playlist media_playlist(const std::string& name) {
+        std::shared_ptr<Rendition> rendition;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refresh_directory();
+            rendition = find(name);
+        }
+        if (!rendition || !refresh(*rendition)) return nullptr;
+
+        std::lock_guard<std::mutex> lock(rendition->mutex);
+        bool live = is_live(rendition->index);
+        if (!rendition->playlist || rendition->live != live) {
+            rendition->live = live;
+            rendition->playlist = build_media(*rendition);
+        }
+        return rendition->playlist;
+    }
+
+    // Where segment index of a rendition lives. Doesn't revalidate unless the
+    // index is past what is known, so a segment listed in a playlist stays
+    // servable even while the playlist is being redone.
+    bool segment(const std::string& name, size_t index, Segment& out) {
+        std::shared_ptr<Rendition> rendition;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rendition = find(name);
+            if (!rendition) {
+                refresh_directory();
+                rendition = find(name);
+            }
+        }
+        if (!rendition) return false;
+        if (lookup(*rendition, index, out)) return true;
+        return refresh(*rendition) && lookup(*rendition, index, out);
+    }
+
+private:
+    // Packets are never split, and a byte rate is probed from this much of
+    // each end of a file. Keyframes are looked for in reads of SCAN_PACKETS.
+    static constexpr uint64_t TS_PACKET_SIZE = 188;
+    static constexpr uint64_t PROBE_SIZE = 1024 * 1024;
+    static constexpr uint64_t SCAN_PACKETS = 512;
+
+    // What the start of a transport stream says about it
+    struct Probe {
+        double byte_rate = 0;
+        uint64_t phase = 0;  // offset of the first packet
+        int video_pid = -1;  // -1 when no PMT was found
+        int pmt_pid = -1;
+        std::shared_ptr<const std::string> header; // PAT and PMT packets
+    };
+
+    // A rendition's segments as last read from the disk
+    struct Index {
+        struct timespec mtime{};
+        uint64_t size = 0;
+        uint64_t bitrate = 0;
+        uint64_t segment_bytes = 0;    // single files only, target length
+        uint64_t phase = 0;
+        int video_pid = -1;
+        int pmt_pid = -1;
+        std::shared_ptr<const std::string> header;
+        size_t finished = 0;           // segments that end at a keyframe, the rest may still grow
+        std::vector<Segment> segments;
+    };
+
+    // Where the next segment starts
+    struct Cut {
+        uint64_t offset = 0;
+        bool has_tables = false;       // starts with PAT and PMT
+    };
+
+    struct Rendition {
+        std::string name;
+        std::string path;
+        bool precut = false;
+
+        std::mutex refresh_mutex;      // held while the files are read
+        std::mutex mutex;              // guards everything below
+        Index index;
+        Playlist playlist;
+        bool live = false;
+    };
+
+    // Rescan the directory when its mtime says renditions came or went.
+    // Known renditions are kept as they are.
+    bool refresh_directory() {
+        struct stat sb;
+        if (stat(media_dir_.c_str(), &sb) != 0 || !S_ISDIR(sb.st_mode)) return false;
+        if (scanned_ && same_time(sb.st_mtim, dir_mtime_)) return true;
+
+        DIR* dir = opendir(media_dir_.c_str());
+        if (!dir) return false;
+        std::map<std::string, std::shared_ptr<Rendition>> renditions;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (!valid_name(name)) continue;
+
+            std::string path = media_dir_ + "/" + name;
+            struct stat entry_sb;
+            if (stat(path.c_str(), &entry_sb) != 0) continue;
+            bool precut = S_ISDIR(entry_sb.st_mode);
+            if (!precut) {
+                if (!S_ISREG(entry_sb.st_mode) || !has_suffix(name, ".ts")) continue;
+                name.resize(name.size() - 3);
+            }
+
+            auto known = renditions_.find(name);
+            if (known != renditions_.end() && known->second->path == path) {
+                renditions[name] = std::move(known->second);
+            } else {
+                auto rendition = std::make_shared<Rendition>();
+                rendition->name = name;
+                rendition->path = path;
+                rendition->precut = precut;
+                renditions[name] = std::move(rendition);
+            }
+        }
+        closedir(dir);
+
+        renditions_.swap(renditions);
+        dir_mtime_ = sb.st_mtim;
+        scanned_ = true;
+        invalidate_master();
+        return true;
+    }
+
+    void invalidate_master() {
+        master_ = nullptr;
+        generation_++;
+    }
+
+    bool lookup(Rendition& rendition, size_t index, Segment& out) {
+        std::lock_guard<std::mutex> lock(rendition.mutex);
+        if (index >= rendition.index.segments.size()) return false;
+        out = rendition.index.segments[index];
+        return true;
+    }
+
+    // Bring a rendition's segment list up to date with the disk. Returns
+    // false when it is gone or has nothing playable. The files are read into
+    // a copy of the index, readers keep using the old one until it is done.
+    bool refresh(Rendition& rendition) {
+        std::lock_guard<std::mutex> refreshing(rendition.refresh_mutex);
+        struct stat sb;
+        if (stat(rendition.path.c_str(), &sb) != 0) return false;
+        uint64_t size = rendition.precut ? 0 : sb.st_size;
+
+        Index index;
+        {
+            std::lock_guard<std::mutex> lock(rendition.mutex);
+            if (!rendition.index.segments.empty() && same_time(sb.st_mtim, rendition.index.mtime) &&
+                size == rendition.index.size) {
+                return true;
+            }
+            index = rendition.index;
+        }
+
+        uint64_t old_bitrate = index.bitrate;
+        bool ok = rendition.precut ? index_precut(rendition.path, index)
+                                   : index_file(rendition.path, index, size);
+        index.mtime = sb.st_mtim;
+        index.size = size;
+        bool bitrate_changed = index.bitrate != old_bitrate;
+        {
+            std::lock_guard<std::mutex> lock(rendition.mutex);
+            ok = ok && !index.segments.empty();
+            rendition.index = std::move(index);
+            rendition.playlist = nullptr;
+        }
+        if (bitrate_changed) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            invalidate_master();
+        }
+        return ok;
+    }
+
+    // Cut a single file into segments. When it only grew since last time
+    // (a recording in progress), the finished segments are kept and cutting
+    // resumes after them.
+    bool index_file(const std::string& path, Index& index, uint64_t size) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        auto& segments = index.segments;
+        uint64_t offset = 0;
+        std::shared_ptr<const std::string> header;
+        if (size > index.size && index.segment_bytes > 0) {
+            if (segments.size() > index.finished) {
+                offset = segments[index.finished].offset;
+                header = segments[index.finished].header;
+                segments.resize(index.finished);
+            } else if (!segments.empty()) {
+                offset = segments.back().offset + segments.back().length;
+            }
+        } else {
+            segments.clear();
+            index.finished = 0;
+            Probe probe = probe_stream(fd, size);
+            index.bitrate = probe.byte_rate > 0 ? (uint64_t)(probe.byte_rate * 8) : fallback_bitrate_;
+            uint64_t packets = (uint64_t)(index.bitrate / 8.0 * target_duration_) / TS_PACKET_SIZE;
+            index.segment_bytes = std::max<uint64_t>(packets, 1) * TS_PACKET_SIZE;
+            index.phase = probe.phase;
+            index.video_pid = probe.video_pid;
+            index.pmt_pid = probe.pmt_pid;
+            index.header = probe.header;
+        }
+
+        double byte_rate = index.bitrate / 8.0;
+        while (offset < size) {
+            Cut cut;
+            bool found = offset + index.segment_bytes < size &&
+                         find_cut(fd, index, offset + index.segment_bytes, size, cut);
+            uint64_t end = found ? cut.offset : size;
+            segments.push_back(Segment{path, offset, end - offset, (end - offset) / byte_rate, header});
+            if (!found) break;
+            index.finished = segments.size();
+            offset = cut.offset;
+            header = cut.has_tables ? nullptr : index.header;
+        }
+        close(fd);
+        return true;
+    }
+
+    // The first keyframe at or after `from`, moved back to the PAT and PMT
+    // right in front of it if there are. Only other streams' packets may sit
+    // between those tables and the keyframe: once a video packet of the
+    // previous GOP follows them, cutting there would start the segment with
+    // frames it can't decode. A stream without marked keyframes within
+    // segment_bytes is cut at `from` instead, its segments still get the
+    // header. False when the file ends first: the segment may still grow.
+    static bool find_cut(int fd, const Index& index, uint64_t from, uint64_t size, Cut& cut) {
+        from -= (from - index.phase) % TS_PACKET_SIZE;
+        if (index.video_pid < 0) {
+            cut.offset = from;
+            return true;
+        }
+
+        uint64_t limit = std::min(size, from + index.segment_bytes);
+        std::vector<unsigned char> buffer(SCAN_PACKETS * TS_PACKET_SIZE);
+        bool pat_seen = false, pmt_seen = false;
+        uint64_t pat = 0;
+        for (uint64_t offset = from; offset + TS_PACKET_SIZE <= limit; offset += buffer.size()) {
+            size_t wanted = std::min<uint64_t>(buffer.size(), limit - offset);
+            ssize_t got = pread(fd, buffer.data(), wanted, offset);
+            if (got < (ssize_t)TS_PACKET_SIZE) return false;
+            for (uint64_t pos = 0; pos + TS_PACKET_SIZE <= (uint64_t)got; pos += TS_PACKET_SIZE) {
+                const unsigned char* packet = &buffer[pos];
+                if (packet[0] != 0x47) continue;
+                int pid = ((packet[1] & 0x1F) << 8) | packet[2];
+                bool unit_start = packet[1] & 0x40;
+                if (pid == 0 && unit_start) {
+                    pat_seen = true;
+                    pmt_seen = false;
+                    pat = offset + pos;
+                } else if (pid == index.pmt_pid && unit_start) {
+                    pmt_seen = pat_seen;
+                } else if (pid == index.video_pid) {
+                    if (unit_start && is_random_access(packet)) {
+                        cut.has_tables = pat_seen && pmt_seen;
+                        cut.offset = cut.has_tables ? pat : offset + pos;
+                        return true;
+                    }
+                    pat_seen = pmt_seen = false;
+                }
+            }
+        }
+        if (limit == size) return false;
+        cut.offset = from;
+        return true;
+    }
+
+    // One segment per .ts file in the directory. Files already probed keep
+    // their duration, only new ones are read.
+    bool index_precut(const std::string& path, Index& index) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return false;
+
+        std::map<std::string, Segment> known;
+        for (auto& segment : index.segments) known.emplace(segment.path, segment);
+
+        std::vector<Segment> segments;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (!valid_name(name) || !has_suffix(name, ".ts")) continue;
+
+            std::string file = path + "/" + name;
+            struct stat sb;
+            if (stat(file.c_str(), &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0) continue;
+
+            auto it = known.find(file);
+            if (it != known.end() && it->second.length == (uint64_t)sb.st_size) {
+                segments.push_back(it->second);
+                continue;
+            }
+            double byte_rate = 0;
+            int fd = open(file.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                byte_rate = probe_stream(fd, sb.st_size).byte_rate;
+                close(fd);
+            }
+            if (byte_rate <= 0) byte_rate = fallback_bitrate_ / 8.0;
+            segments.push_back(Segment{file, 0, (uint64_t)sb.st_size, sb.st_size / byte_rate, nullptr});
+        }
+        closedir(dir);
+
+        std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            uint64_t a_number = trailing_number(a.path), b_number = trailing_number(b.path);
+            return a_number != b_number ? a_number < b_number : a.path < b.path;
+        });
+
+        uint64_t bytes = 0;
+        double duration = 0;
+        for (auto& segment : segments) {
+            bytes += segment.length;
+            duration += segment.duration;
+        }
+        index.bitrate = duration > 0 ? (uint64_t)(bytes * 8 / duration) : fallback_bitrate_;
+        index.segments.swap(segments);
+        index.finished = index.segments.size();
+        return true;
+    }
+
+    Playlist build_master(const std::vector<std::shared_ptr<Rendition>>& candidates) {
+        std::vector<std::pair<uint64_t, std::string>> renditions;
+        for (auto& rendition : candidates) {
+            if (!refresh(*rendition)) continue;
+            std::lock_guard<std::mutex> lock(rendition->mutex);
+            renditions.emplace_back(rendition->index.bitrate, rendition->name);
+        }
+        std::sort(renditions.begin(), renditions.end());
+
+        auto playlist = std::make_shared<std::string>("#EXTM3U\n#EXT-X-VERSION:3\n");
+        for (auto& rendition : renditions) {
+            *playlist += "#EXT-X-STREAM-INF:BANDWIDTH=" + std::to_string(rendition.first) + "\n";
+            *playlist += rendition.second + "/index.m3u8\n";
+        }
+        return playlist;
+    }
+
+    // A recording still being written is an EVENT playlist without an end,
+    // and its last, unfinished segment isn't listed yet
+    Playlist build_media(const Rendition& rendition) {
+        const Index& index = rendition.index;
+        size_t count = index.segments.size();
+        if (rendition.live && !rendition.precut && index.finished > 0) {
+            count = index.finished;
+        }
+
+        double longest = 0;
+        for (size_t i = 0; i < count; i++) {
+            longest = std::max(longest, index.segments[i].duration);
+        }
+
+        auto playlist = std::make_shared<std::string>();
+        char line[64];
+        *playlist += "#EXTM3U\n#EXT-X-VERSION:3\n";
+        snprintf(line, sizeof(line), "#EXT-X-TARGETDURATION:%d\n", (int)std::ceil(longest));
+        *playlist += line;
+        *playlist += "#EXT-X-MEDIA-SEQUENCE:0\n";
+        *playlist += rendition.live ? "#EXT-X-PLAYLIST-TYPE:EVENT\n" : "#EXT-X-PLAYLIST-TYPE:VOD\n";
+        for (size_t i = 0; i < count; i++) {
+            snprintf(line, sizeof(line), "#EXTINF:%.3f,\n%zu.ts\n", index.segments[i].duration, i);
+            *playlist += line;
+        }
+        if (!rendition.live) *playlist += "#EXT-X-ENDLIST\n";
+        return playlist;
+    }
+
+    // Written to within the last two target durations
+    bool is_live(const Index& index) const {
+        return time(nullptr) - index.mtime.tv_sec < 2 * target_duration_;
+    }
+
+    std::shared_ptr<Rendition> find(const std::string& name) {
+        auto it = renditions_.find(name);
+        return it == renditions_.end() ? nullptr : it->second;
+    }
+
+    // Packet boundary, PAT and PMT, video PID and byte rate of a transport
+    // stream from PROBE_SIZE at either end. The byte rate is from the first
+    // and last PCR of one PID, 0 when that isn't possible.
+    static Probe probe_stream(int fd, uint64_t size) {
+        Probe probe;
+        std::vector<unsigned char> buffer(std::min(size, PROBE_SIZE));
+        if (buffer.size() < 3 * TS_PACKET_SIZE ||
+            pread(fd, buffer.data(), buffer.size(), 0) != (ssize_t)buffer.size()) {
+            return probe;
+        }
+
+        // Find the packet boundary: three sync bytes a packet apart
+        uint64_t phase = 0;
+        while (phase < TS_PACKET_SIZE &&
+               !(buffer[phase] == 0x47 && buffer[phase + TS_PACKET_SIZE] == 0x47 &&
+                 buffer[phase + 2 * TS_PACKET_SIZE] == 0x47)) {
+            phase++;
+        }
+        if (phase == TS_PACKET_SIZE) return probe;
+        probe.phase = phase;
+        find_tables(buffer, phase, probe);
+
+        int pid = -1;
+        uint64_t first_pos = 0, first_pcr = 0;
+        for (uint64_t pos = phase; pos + TS_PACKET_SIZE <= buffer.size(); pos += TS_PACKET_SIZE) {
+            if (read_pcr(&buffer[pos], pid, first_pcr)) {
+                first_pos = pos;
+                break;
+            }
+        }
+        if (pid < 0) return probe;
+
+        uint64_t tail = size > buffer.size() ? size - buffer.size() : 0;
+        tail = tail < phase ? phase : tail - (tail - phase) % TS_PACKET_SIZE;
+        ssize_t tail_size = pread(fd, buffer.data(), buffer.size(), tail);
+        uint64_t last_pos = 0, last_pcr = 0;
+        for (uint64_t pos = 0; tail_size > 0 && pos + TS_PACKET_SIZE <= (uint64_t)tail_size;
+             pos += TS_PACKET_SIZE) {
+            uint64_t pcr;
+            if (read_pcr(&buffer[pos], pid, pcr)) {
+                last_pos = tail + pos;
+                last_pcr = pcr;
+            }
+        }
+        if (last_pos <= first_pos || last_pcr <= first_pcr) return probe;
+
+        // PCR runs at 27 MHz
+        probe.byte_rate = (last_pos - first_pos) / ((last_pcr - first_pcr) / 27000000.0);
+        return probe;
+    }
+
+    // The first PAT, the PMT of its first program and the video stream that
+    // PMT lists. Tables are assumed to fit in the packet they start in.
+    static void find_tables(const std::vector<unsigned char>& buffer, uint64_t phase, Probe& probe) {
+        std::string pat;
+        int pmt_pid = -1;
+        for (uint64_t pos = phase; pos + TS_PACKET_SIZE <= buffer.size(); pos += TS_PACKET_SIZE) {
+            const unsigned char* packet = &buffer[pos];
+            int pid = ((packet[1] & 0x1F) << 8) | packet[2];
+            const unsigned char* section = table_section(packet);
+            if (!section) continue;
+            size_t length = ((section[1] & 0x0F) << 8) | section[2];
+            if (length < 9 || section + 3 + length > packet + TS_PACKET_SIZE) continue;
+
+            if (pid == 0 && pmt_pid < 0 && section[0] == 0x00) {
+                // Programs follow the 5 byte header, the CRC ends the section
+                for (size_t i = 8; i + 4 <= 3 + length - 4; i += 4) {
+                    int program = (section[i] << 8) | section[i + 1];
+                    if (program == 0) continue; // network PID
+                    pmt_pid = ((section[i + 2] & 0x1F) << 8) | section[i + 3];
+                    pat.assign(reinterpret_cast<const char*>(packet), TS_PACKET_SIZE);
+                    break;
+                }
+            } else if (pid == pmt_pid && section[0] == 0x02) {
+                size_t info_length = ((section[10] & 0x0F) << 8) | section[11];
+                size_t i = 12 + info_length;
+                while (i + 5 <= 3 + length - 4) {
+                    int type = section[i];
+                    int stream_pid = ((section[i + 1] & 0x1F) << 8) | section[i + 2];
+                    if (is_video_type(type)) {
+                        probe.video_pid = stream_pid;
+                        break;
+                    }
+                    i += 5 + (((section[i + 3] & 0x0F) << 8) | section[i + 4]);
+                }
+                if (probe.video_pid < 0) return;
+                probe.pmt_pid = pmt_pid;
+                probe.header = std::make_shared<const std::string>(
+                    pat + std::string(reinterpret_cast<const char*>(packet), TS_PACKET_SIZE));
+                return;
+            }
+        }
+    }
+
+    // Start of the PSI section a packet begins, nullptr if it doesn't
+    static const unsigned char* table_section(const unsigned char* packet) {
+        if (packet[0] != 0x47 || !(packet[1] & 0x40) || !(packet[3] & 0x10)) return nullptr;
+        size_t start = 4;
+        if (packet[3] & 0x20) start += 1 + packet[4];
+        if (start >= TS_PACKET_SIZE) return nullptr;
+        start += 1 + packet[start]; // pointer field
+        return start + 12 <= TS_PACKET_SIZE ? packet + start : nullptr;
+    }
+
+    // MPEG-1/2, MPEG-4 part 2, H.264 and HEVC video
+    static bool is_video_type(int type) {
+        return type == 0x01 || type == 0x02 || type == 0x10 || type == 0x1B || type == 0x24;
+    }
+
+    // Set on the packet that starts a keyframe
+    static bool is_random_access(const unsigned char* packet) {
+        return (packet[3] & 0x20) && packet[4] > 0 && (packet[5] & 0x40);
+    }
+
+    // The PCR carried by a packet's adaptation field. A pid of -1 accepts
+    // any PID and is set to the one found.
+    static bool read_pcr(const unsigned char* packet, int& pid, uint64_t& pcr) {
+        if (packet[0] != 0x47 || !(packet[3] & 0x20) || packet[4] < 7 || !(packet[5] & 0x10)) {
+            return false;
+        }
+        int packet_pid = ((packet[1] & 0x1F) << 8) | packet[2];
+        if (pid >= 0 && packet_pid != pid) return false;
+
+        uint64_t base = ((uint64_t)packet[6] << 25) | (packet[7] << 17) | (packet[8] << 9) |
+                        (packet[9] << 1) | (packet[10] >> 7);
+        uint64_t extension = ((packet[10] & 1) << 8) | packet[11];
+        pcr = base * 300 + extension;
+        pid = packet_pid;
+        return true;
+    }
+
+    // Names end up in URLs, keep to ones that need no escaping
+    static bool valid_name(const std::string& name) {
+        if (name.empty() || name[0] == '.') return false;
+        for (char c : name) {
+            if (!isalnum((unsigned char)c) && c != '-' && c != '_' && c != '.') return false;
+        }
+        return true;
+    }
+
+    static bool has_suffix(const std::string& name, const char* suffix) {
+        size_t length = strlen(suffix);
+        return name.size() > length && name.compare(name.size() - length, length, suffix) == 0;
+    }
+
+    // seg9.ts sorts before seg10.ts
+    static uint64_t trailing_number(const std::string& path) {
+        size_t end = path.rfind('.');
+        size_t start = end;
+        while (start > 0 && end - start < 18 && isdigit((unsigned char)path[start - 1])) start--;
+        return start < end ? std::stoull(path.substr(start, end - start)) : 0;
+    }
+
+    static bool same_time(const struct timespec& a, const struct timespec& b) {
+        return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+    }
+
+    std::string media_dir_;
+    double target_duration_;
+    uint64_t fallback_bitrate_;
+
+    std::mutex mutex_; // guards everything below
+    bool scanned_ = false;
+    struct timespec dir_mtime_{};
+    std::map<std::string, std::shared_ptr<Rendition>> renditions_;
+    Playlist master_;
+    uint64_t generation_ = 0; // bumped whenever master_ goes stale
+};
@@ -0,0 +1,762 @@
+// Load generator for the zero-copy test server.
+//
+// Opens N connections (optionally keep-alive) against the server and pushes
+// M requests through them, spread over the endpoints of a weighted method
+// mix. Reports latency percentiles, throughput and CPU time per request for
+// every method, and can append the results to a CSV file and/or write them
+// as JSON so runs can be compared.
+//
+// Build: g++ -std=c++17 -O2 load_generator.cpp -o load_generator -lpthread
+// Usage: ./load_generator --mix mmap:1,sendfile:3 --connections 64 --requests 1000
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 18080;
+    int connections = 8;
+    int requests = 100;
+    int threads = 1;
+    bool keep_alive = true;
+    bool per_method = false; // one phase per method instead of mixing them
+    int timeout_s = 300;
+    pid_t server_pid = 0;    // for server CPU per request
+    std::string label;
+    std::string csv_file;
+    std::string json_file;
+    std::vector<std::pair<std::string, int>> mix; // endpoint, weight
+};
+
+// Latencies and volume of one method within a phase
+struct MethodStats {
+    std::vector<uint32_t> latencies_us;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+
+    void merge(const MethodStats& other) {
+        latencies_us.insert(latencies_us.end(), other.latencies_us.begin(), other.latencies_us.end());
+        bytes += other.bytes;
+        errors += other.errors;
+    }
+};
+
+// One row of the report
+struct Result {
+    std::string method;
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    double duration_s = 0;
+    double requests_per_s = 0;
+    double throughput_mbps = 0;
+    double p50_us = 0, p90_us = 0, p99_us = 0, p999_us = 0, max_us = 0;
+    double server_cpu_us = -1; // per request, -1 when not measured
+    double client_cpu_us = 0;  // per request
+    uint64_t connections_lost = 0; // in the phase, gave up connecting
+};
+
+// HTTP/1.1 response reader, just enough to find where a response ends:
+// Content-Length, chunked and close-delimited bodies
+class ResponseParser {
+public:
+    void reset() {
+        state_ = HEADERS;
+        head_.clear();
+        line_.clear();
+        remaining_ = 0;
+        body_bytes_ = 0;
+        status_ = 0;
+        close_ = false;
+    }
+
+    // Consume bytes, returns how many belong to the current response
+    size_t feed(const char* data, size_t size) {
+        size_t used = 0;
+        while (used < size && state_ != DONE && state_ != ERROR) {
+            switch (state_) {
+                case HEADERS: {
+                    size_t start = head_.size() >= 3 ? head_.size() - 3 : 0;
+                    head_.append(data + used, size - used);
+                    size_t end = head_.find("\r\n\r\n", start);
+                    if (end == std::string::npos) {
+                        used = size;
+                        break;
+                    }
+                    used = size - (head_.size() - (end + 4));
+                    head_.resize(end + 4);
+                    parse_headers();
+                    break;
+                }
+                case BODY: {
+                    size_t n = std::min<uint64_t>(remaining_, size - used);
+                    used += n;
+                    body_bytes_ += n;
+                    remaining_ -= n;
+                    if (remaining_ == 0) state_ = DONE;
+                    break;
+                }
+                case UNTIL_CLOSE:
+                    body_bytes_ += size - used;
+                    used = size;
+                    break;
+                case CHUNK_SIZE:
+                case CHUNK_TRAILER: {
+                    char c = data[used++];
+                    if (c != '\n') {
+                        line_ += c;
+                        break;
+                    }
+                    if (!line_.empty() && line_.back() == '\r') line_.pop_back();
+                    if (state_ == CHUNK_TRAILER) {
+                        if (line_.empty()) state_ = DONE;
+                    } else {
+                        remaining_ = strtoull(line_.c_str(), nullptr, 16);
+                        state_ = remaining_ == 0 ? CHUNK_TRAILER : CHUNK_DATA;
+                    }
+                    line_.clear();
+                    break;
+                }
+                case CHUNK_DATA: {
+                    size_t n = std::min<uint64_t>(remaining_, size - used);
+                    used += n;
+                    body_bytes_ += n;
+                    remaining_ -= n;
+                    if (remaining_ == 0) {
+                        remaining_ = 2; // CRLF after the chunk
+                        state_ = CHUNK_END;
+                    }
+                    break;
+                }
+                case CHUNK_END: {
+                    size_t n = std::min<uint64_t>(remaining_, size - used);
+                    used += n;
+                    remaining_ -= n;
+                    if (remaining_ == 0) state_ = CHUNK_SIZE;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        return used;
+    }
+
+    // The server closed the connection, which ends a close-delimited body
+    void eof() {
+        state_ = state_ == UNTIL_CLOSE ? DONE : ERROR;
+    }
+
+    bool done() const { return state_ == DONE; }
+    bool error() const { return state_ == ERROR; }
+    bool failed() const { return state_ == ERROR || (state_ == DONE && (status_ < 200 || status_ >= 400)); }
+    bool wants_close() const { return close_; }
+    uint64_t body_bytes() const { return body_bytes_; }
+
+private:
+    enum State { HEADERS, BODY, UNTIL_CLOSE, CHUNK_SIZE, CHUNK_DATA, CHUNK_END, CHUNK_TRAILER, DONE, ERROR };
+
+    static bool header_is(const std::string& line, const char* name) {
+        size_t length = strlen(name);
+        return line.size() > length && line[length] == ':' && strncasecmp(line.c_str(), name, length) == 0;
+    }
+
+    static std::string header_value(const std::string& line) {
+        size_t start = line.find(':') + 1;
+        while (start < line.size() && line[start] == ' ') start++;
+        return line.substr(start);
+    }
+
+    void parse_headers() {
+        if (head_.compare(0, 5, "HTTP/") != 0 || head_.size() < 12) {
+            state_ = ERROR;
+            return;
+        }
+        status_ = atoi(head_.c_str() + 9);
+        bool http10 = head_.compare(0, 8, "HTTP/1.0") == 0;
+        bool has_length = false, chunked = false;
+        close_ = http10;
+
+        size_t pos = head_.find("\r\n") + 2;
+        while (pos < head_.size() - 2) {
+            size_t end = head_.find("\r\n", pos);
+            std::string line = head_.substr(pos, end - pos);
+            pos = end + 2;
+            if (header_is(line, "Content-Length")) {
+                has_length = true;
+                remaining_ = strtoull(header_value(line).c_str(), nullptr, 10);
+            } else if (header_is(line, "Transfer-Encoding")) {
+                chunked = strcasecmp(header_value(line).c_str(), "chunked") == 0;
+            } else if (header_is(line, "Connection")) {
+                std::string value = header_value(line);
+                if (strcasecmp(value.c_str(), "close") == 0) close_ = true;
+                if (strcasecmp(value.c_str(), "keep-alive") == 0) close_ = false;
+            }
+        }
+
+        if (chunked) {
+            state_ = CHUNK_SIZE;
+        } else if (has_length) {
+            state_ = remaining_ == 0 ? DONE : BODY;
+        } else {
+            state_ = UNTIL_CLOSE;
+            close_ = true;
+        }
+    }
+
+    State state_ = HEADERS;
+    std::string head_;
+    std::string line_;
+    uint64_t remaining_ = 0;
+    uint64_t body_bytes_ = 0;
+    int status_ = 0;
+    bool close_ = false;
+};
+
+// Requests are handed out from one counter shared by every connection, the
+// n-th request goes to the method at slot n of the weighted schedule
+struct Schedule {
+    std::vector<int> slots; // method index per slot
+    int total = 0;
+    std::atomic<int> next{0};
+
+    int claim() {
+        int n = next.fetch_add(1);
+        return n < total ? slots[n % slots.size()] : -1;
+    }
+};
+
+// Drives a share of the connections with one epoll loop
+class Worker {
+public:
+    Worker(const Options& options, const sockaddr_in& address, const std::vector<std::string>& methods,
+           Schedule& schedule, int connections)
+        : options_(options), address_(address), methods_(methods), schedule_(schedule),
+          connections_(connections), stats_(methods.size()) {}
+
+    void run() {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        for (auto& connection : connections_) start_request(connection);
+
+        auto deadline = Clock::now() + std::chrono::seconds(options_.timeout_s);
+        std::vector<epoll_event> events(256);
+        while (active_ > 0 && Clock::now() < deadline) {
+            int timeout_ms = 1000;
+            for (Connection* connection : retrying_) {
+                auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(connection->retry_at - Clock::now());
+                timeout_ms = std::max<int>(0, std::min<int>(timeout_ms, wait.count() + 1));
+            }
+            int count = epoll_wait(epoll_fd_, events.data(), events.size(), timeout_ms);
+            retry_connections();
+            for (int i = 0; i < count; i++) {
+                Connection& connection = *static_cast<Connection*>(events[i].data.ptr);
+                if (connection.sending) {
+                    on_writable(connection);
+                } else {
+                    on_readable(connection);
+                }
+            }
+        }
+
+        // Whatever is still outstanding at the deadline counts as failed
+        for (auto& connection : connections_) {
+            if (connection.method >= 0) stats_[connection.method].errors++;
+            close_connection(connection);
+        }
+        close(epoll_fd_);
+    }
+
+    const std::vector<MethodStats>& stats() const { return stats_; }
+    uint64_t connections_lost() const { return lost_; }
+    int connect_errno() const { return connect_errno_; }
+
+private:
+    // Connecting fails for a while when ephemeral ports run out (every
+    // request on a new connection), retried with a backoff of 2 ms doubling
+    // up to about a second before the connection is given up on
+    static constexpr int MAX_CONNECT_ATTEMPTS = 12;
+
+    struct Connection {
+        int fd = -1;
+        int method = -1;
+        bool sending = false;
+        int attempts = 0;        // failed connects in a row
+        Clock::time_point retry_at;
+        Clock::time_point start;
+        std::string request;
+        size_t sent = 0;
+        ResponseParser parser;
+    };
+
+    void start_request(Connection& connection) {
+        connection.method = schedule_.claim();
+        if (connection.method < 0) {
+            close_connection(connection);
+            return;
+        }
+        active_++;
+        send_request(connection);
+    }
+
+    // Send the request claimed by the connection, connecting first if needed
+    void send_request(Connection& connection) {
+        if (connection.fd < 0 && !open_connection(connection)) {
+            connect_errno_ = errno;
+            if (++connection.attempts >= MAX_CONNECT_ATTEMPTS) {
+                stats_[connection.method].errors++;
+                connection.method = -1;
+                lost_++;
+                active_--;
+                return;
+            }
+            connection.retry_at = Clock::now() + std::chrono::milliseconds(1 << std::min(connection.attempts, 10));
+            retrying_.push_back(&connection);
+            return;
+        }
+        connection.attempts = 0;
+
+        connection.start = Clock::now();
+        connection.request = "GET /" + methods_[connection.method] + " HTTP/1.1\r\nHost: " + options_.host +
+                             (options_.keep_alive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+        connection.sent = 0;
+        connection.sending = true;
+        connection.parser.reset();
+        watch(connection, EPOLLOUT);
+    }
+
+    bool open_connection(Connection& connection) {
+        connection.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (connection.fd < 0) return false;
+        int one = 1;
+        setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(connection.fd, reinterpret_cast<const sockaddr*>(&address_), sizeof(address_)) < 0 &&
+            errno != EINPROGRESS) {
+            close(connection.fd);
+            connection.fd = -1;
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLOUT;
+        event.data.ptr = &connection;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, connection.fd, &event);
+        return true;
+    }
+
+    void retry_connections() {
+        auto now = Clock::now();
+        std::vector<Connection*> due;
+        for (size_t i = 0; i < retrying_.size();) {
+            if (retrying_[i]->retry_at <= now) {
+                due.push_back(retrying_[i]);
+                retrying_[i] = retrying_.back();
+                retrying_.pop_back();
+            } else {
+                i++;
+            }
+        }
+        for (Connection* connection : due) send_request(*connection);
+    }
+
+    void watch(Connection& connection, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.ptr = &connection;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    void close_connection(Connection& connection) {
+        if (connection.fd >= 0) {
+            close(connection.fd); // also drops it from the epoll set
+            connection.fd = -1;
+        }
+    }
+
+    void on_writable(Connection& connection) {
+        while (connection.sent < connection.request.size()) {
+            ssize_t n = send(connection.fd, connection.request.data() + connection.sent,
+                             connection.request.size() - connection.sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EAGAIN) return;
+            if (n <= 0) {
+                finish_request(connection, false);
+                return;
+            }
+            connection.sent += n;
+        }
+        connection.sending = false;
+        watch(connection, EPOLLIN);
+    }
+
+    void on_readable(Connection& connection) {
+        char buffer[64 * 1024];
+        while (true) {
+            ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EAGAIN) return;
+            if (n <= 0) {
+                connection.parser.eof();
+                finish_request(connection, connection.parser.done());
+                return;
+            }
+            connection.parser.feed(buffer, n);
+            // A response that can't be parsed won't end either, don't wait
+            // for the timeout on it
+            if (connection.parser.done() || connection.parser.error()) {
+                finish_request(connection, connection.parser.done());
+                return;
+            }
+        }
+    }
+
+    void finish_request(Connection& connection, bool ok) {
+        MethodStats& stats = stats_[connection.method];
+        if (ok && !connection.parser.failed()) {
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - connection.start);
+            stats.latencies_us.push_back(latency.count());
+            stats.bytes += connection.parser.body_bytes();
+        } else {
+            stats.errors++;
+        }
+        active_--;
+
+        if (!ok || !options_.keep_alive || connection.parser.wants_close()) close_connection(connection);
+        start_request(connection);
+    }
+
+    const Options& options_;
+    sockaddr_in address_;
+    const std::vector<std::string>& methods_;
+    Schedule& schedule_;
+    std::vector<Connection> connections_;
+    std::vector<MethodStats> stats_;
+    std::vector<Connection*> retrying_; // waiting to connect again
+    uint64_t lost_ = 0;
+    int connect_errno_ = 0;
+    int epoll_fd_ = -1;
+    int active_ = 0;
+};
+
+// CPU time (user + system) of a process in microseconds, -1 if unknown
+double process_cpu_us(pid_t pid) {
+    if (pid == 0) {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat;
+    if (!std::getline(file, stat)) return -1;
+    // The command name can contain spaces, fields are counted after it
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) return -1;
+    std::vector<std::string> fields;
+    size_t start = pos + 2;
+    while (start < stat.size()) {
+        size_t end = stat.find(' ', start);
+        if (end == std::string::npos) end = stat.size();
+        fields.push_back(stat.substr(start, end - start));
+        start = end + 1;
+    }
+    if (fields.size() < 13) return -1;
+    double ticks = atof(fields[11].c_str()) + atof(fields[12].c_str()); // utime, stime
+    return ticks * 1e6 / sysconf(_SC_CLK_TCK);
+}
+
+double percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, (size_t)std::ceil(p * sorted.size()) - (p > 0 ? 1 : 0));
+    return sorted[index];
+}
+
+// Run one phase: all connections, `requests` requests over `methods`
+std::vector<Result> run_phase(const Options& options, const sockaddr_in& address,
+                              const std::vector<std::pair<std::string, int>>& mix, int requests) {
+    std::vector<std::string> methods;
+    Schedule schedule;
+    schedule.total = requests;
+    for (size_t i = 0; i < mix.size(); i++) {
+        methods.push_back(mix[i].first);
+        for (int w = 0; w < mix[i].second; w++) schedule.slots.push_back(i);
+    }
+
+    int threads = std::max(1, std::min(options.threads, options.connections));
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < threads; t++) {
+        int connections = options.connections / threads + (t < options.connections % threads ? 1 : 0);
+        workers.emplace_back(new Worker(options, address, methods, schedule, connections));
+    }
+
+    double server_cpu_start = options.server_pid ? process_cpu_us(options.server_pid) : -1;
+    double client_cpu_start = process_cpu_us(0);
+    auto start = Clock::now();
+
+    std::vector<std::thread> running;
+    for (auto& worker : workers) running.emplace_back([&worker] { worker->run(); });
+    for (auto& thread : running) thread.join();
+
+    double duration_s = std::chrono::duration<double>(Clock::now() - start).count();
+    double server_cpu = server_cpu_start >= 0 ? process_cpu_us(options.server_pid) - server_cpu_start : -1;
+    double client_cpu = process_cpu_us(0) - client_cpu_start;
+
+    std::vector<MethodStats> stats(methods.size());
+    uint64_t completed = 0;
+    uint64_t lost = 0;
+    int connect_errno = 0;
+    for (auto& worker : workers) {
+        for (size_t i = 0; i < methods.size(); i++) stats[i].merge(worker->stats()[i]);
+        lost += worker->connections_lost();
+        if (worker->connections_lost() > 0) connect_errno = worker->connect_errno();
+    }
+    for (auto& s : stats) completed += s.latencies_us.size() + s.errors;
+    // The numbers below describe fewer connections than asked for then
+    if (lost > 0) {
+        std::cerr << "Warning: " << lost << " of " << options.connections
+                  << " connections gave up after failing to connect (" << strerror(connect_errno) << ")\n";
+    }
+
+    // CPU can only be told apart per phase, in a mix every method gets the
+    // phase average
+    std::vector<Result> results;
+    for (size_t i = 0; i < methods.size(); i++) {
+        MethodStats& s = stats[i];
+        std::sort(s.latencies_us.begin(), s.latencies_us.end());
+        Result r;
+        r.method = methods[i];
+        r.requests = s.latencies_us.size();
+        r.errors = s.errors;
+        r.bytes = s.bytes;
+        r.duration_s = duration_s;
+        r.requests_per_s = r.requests / duration_s;
+        r.throughput_mbps = (s.bytes / 1024.0 / 1024.0) / duration_s;
+        r.p50_us = percentile(s.latencies_us, 0.50);
+        r.p90_us = percentile(s.latencies_us, 0.90);
+        r.p99_us = percentile(s.latencies_us, 0.99);
+        r.p999_us = percentile(s.latencies_us, 0.999);
+        r.max_us = s.latencies_us.empty() ? 0 : s.latencies_us.back();
+        if (completed > 0) {
+            r.server_cpu_us = server_cpu >= 0 ? server_cpu / completed : -1;
+            r.client_cpu_us = client_cpu / completed;
+        }
+        r.connections_lost = lost;
+        results.push_back(r);
+    }
+    return results;
+}
+
+void print_results(const std::vector<Result>& results) {
+    std::cout << "\n============================== LOAD TEST RESULTS ==============================\n";
+    std::cout << "Method          |   Reqs | Errs |  Req/s |    MB/s | p50 ms | p90 ms | p99 ms | p999 ms | srv CPU us/req\n";
+    std::cout << "----------------|--------|------|--------|---------|--------|--------|--------|---------|---------------\n";
+    for (const auto& r : results) {
+        printf("%-15s | %6llu | %4llu | %6.1f | %7.1f | %6.2f | %6.2f | %6.2f | %7.2f | ",
+               r.method.c_str(), (unsigned long long)r.requests, (unsigned long long)r.errors,
+               r.requests_per_s, r.throughput_mbps,
+               r.p50_us / 1000.0, r.p90_us / 1000.0, r.p99_us / 1000.0, r.p999_us / 1000.0);
+        if (r.server_cpu_us >= 0) printf("%14.1f\n", r.server_cpu_us);
+        else printf("%14s\n", "-");
+    }
+    std::cout << "===============================================================================\n\n";
+}
+
+void write_csv(const Options& options, const std::vector<Result>& results) {
+    std::ifstream existing(options.csv_file);
+    bool has_header = existing.peek() != std::ifstream::traits_type::eof();
+    existing.close();
+
+    std::ofstream file(options.csv_file, std::ios::app);
+    if (!has_header) {
+        file << "label,method,connections,keep_alive,requests,errors,bytes,duration_s,requests_per_s,"
+                "throughput_mbps,p50_us,p90_us,p99_us,p999_us,max_us,server_cpu_us_per_req,client_cpu_us_per_req,"
+                "connections_lost\n";
+    }
+    for (const auto& r : results) {
+        file << options.label << ',' << r.method << ',' << options.connections << ',' << options.keep_alive << ','
+             << r.requests << ',' << r.errors << ',' << r.bytes << ',' << r.duration_s << ',' << r.requests_per_s << ','
+             << r.throughput_mbps << ',' << r.p50_us << ',' << r.p90_us << ',' << r.p99_us << ',' << r.p999_us << ','
+             << r.max_us << ',' << r.server_cpu_us << ',' << r.client_cpu_us << ',' << r.connections_lost << '\n';
+    }
+}
+
+// A JSON string literal holding text
+std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + '"';
+}
+
+void write_json(const Options& options, const std::vector<Result>& results) {
+    std::ofstream file(options.json_file);
+    file << "{\n  \"label\": " << json_string(options.label) << ",\n"
+         << "  \"connections\": " << options.connections << ",\n"
+         << "  \"keep_alive\": " << (options.keep_alive ? "true" : "false") << ",\n"
+         << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        file << "    {\"method\": " << json_string(r.method) << ", \"requests\": " << r.requests
+             << ", \"errors\": " << r.errors << ", \"bytes\": " << r.bytes
+             << ", \"duration_s\": " << r.duration_s << ", \"requests_per_s\": " << r.requests_per_s
+             << ", \"throughput_mbps\": " << r.throughput_mbps
+             << ", \"p50_us\": " << r.p50_us << ", \"p90_us\": " << r.p90_us
+             << ", \"p99_us\": " << r.p99_us << ", \"p999_us\": " << r.p999_us << ", \"max_us\": " << r.max_us
+             << ", \"server_cpu_us_per_req\": ";
+        if (r.server_cpu_us >= 0) file << r.server_cpu_us;
+        else file << "null";
+        file << ", \"client_cpu_us_per_req\": " << r.client_cpu_us
+             << ", \"connections_lost\": " << r.connections_lost << "}"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+}
+
+void usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --host HOST            server address (127.0.0.1)\n"
+              << "  --port PORT            server port (18080)\n"
+              << "  --connections N        concurrent connections (8)\n"
+              << "  --requests M           requests per phase (100)\n"
+              << "  --threads T            client threads (1)\n"
+              << "  --mix a:w,b:w          endpoints and their weights (mmap:1,sendfile:1)\n"
+              << "  --per-method           run every endpoint of the mix as its own phase\n"
+              << "  --no-keep-alive        new connection for every request\n"
+              << "  --server-pid PID       measure the server's CPU time per request\n"
+              << "  --timeout S            give up on a phase after S seconds (300)\n"
+              << "  --label NAME           run name in the CSV / JSON output (timestamp)\n"
+              << "  --csv FILE             append the results to FILE\n"
+              << "  --json FILE            write the results to FILE\n";
+}
+
+bool parse_mix(const std::string& text, std::vector<std::pair<std::string, int>>& mix) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        int weight = 1;
+        size_t colon = item.rfind(':');
+        if (colon != std::string::npos) {
+            weight = atoi(item.c_str() + colon + 1);
+            item = item.substr(0, colon);
+        }
+        if (!item.empty() && item[0] == '/') item = item.substr(1);
+        if (weight <= 0) return false;
+        mix.emplace_back(item, weight);
+    }
+    return !mix.empty();
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--host") options.host = value();
+        else if (arg == "--port") options.port = atoi(value().c_str());
+        else if (arg == "--connections") options.connections = atoi(value().c_str());
+        else if (arg == "--requests") options.requests = atoi(value().c_str());
+        else if (arg == "--threads") options.threads = atoi(value().c_str());
+        else if (arg == "--per-method") options.per_method = true;
+        else if (arg == "--no-keep-alive") options.keep_alive = false;
+        else if (arg == "--server-pid") options.server_pid = atoi(value().c_str());
+        else if (arg == "--timeout") options.timeout_s = atoi(value().c_str());
+        else if (arg == "--label") options.label = value();
+        else if (arg == "--csv") options.csv_file = value();
+        else if (arg == "--json") options.json_file = value();
+        else if (arg == "--mix") {
+            if (!parse_mix(value(), options.mix)) {
+                std::cerr << "Invalid --mix, expected endpoint:weight,...\n";
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (options.mix.empty()) options.mix = {{"mmap", 1}, {"sendfile", 1}};
+    if (options.connections <= 0 || options.requests <= 0) {
+        std::cerr << "--connections and --requests must be positive\n";
+        return 1;
+    }
+    if (options.label.empty()) {
+        char buffer[32];
+        time_t now = time(nullptr);
+        strftime(buffer, sizeof(buffer), "%Y%m%d-%H%M%S", localtime(&now));
+        options.label = buffer;
+    }
+
+    addrinfo hints{}, *resolved = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(options.host.c_str(), nullptr, &hints, &resolved) != 0 || !resolved) {
+        std::cerr << "Could not resolve " << options.host << "\n";
+        return 1;
+    }
+    sockaddr_in address = *reinterpret_cast<sockaddr_in*>(resolved->ai_addr);
+    address.sin_port = htons(options.port);
+    freeaddrinfo(resolved);
+
+    std::cout << "Load test " << options.label << ": " << options.connections << " connections, "
+              << options.requests << " requests" << (options.per_method ? " per method" : "")
+              << (options.keep_alive ? ", keep-alive" : ", no keep-alive") << "\n";
+
+    std::vector<Result> results;
+    if (options.per_method) {
+        for (const auto& method : options.mix) {
+            std::cout << "Testing: " << method.first << "\n";
+            auto phase = run_phase(options, address, {{method.first, 1}}, options.requests);
+            results.insert(results.end(), phase.begin(), phase.end());
+        }
+    } else {
+        results = run_phase(options, address, options.mix, options.requests);
+    }
+
+    print_results(results);
+    if (!options.csv_file.empty()) write_csv(options, results);
+    if (!options.json_file.empty()) write_json(options, results);
+
+    uint64_t errors = 0;
+    for (const auto& r : results) errors += r.errors;
+    return errors > 0 ? 2 : 0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// Read-only mappings of whole files, kept mapped between requests.
+//
+// Mapping and unmapping a big file on every request means building and
+// tearing down its page tables each time, plus a TLB shootdown on every core
+// that ran the process. Here a file is mapped once and the mapping is shared:
+// entries are keyed by inode so any path to the same file finds it, and are
+// checked against the file's mtime and size on every lookup so a rewritten
+// file gets a fresh mapping. The cache is bounded by mapped bytes (address
+// space, not memory) and drops the least recently used mappings beyond that.
+//
+// Mappings are handed out as shared_ptr and unmapped when the last reference
+// goes, a response sending from one keeps it alive even after eviction.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+class MappingCache {
+public:
+    struct Mapping {
+        const char* data = nullptr;
+        size_t size = 0;
+        struct timespec mtime{};
+
+        Mapping() = default;
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+        ~Mapping() {
+            if (data) munmap(const_cast<char*>(data), size);
+        }
+    };
+    using Ref = std::shared_ptr<const Mapping>;
+
+    explicit MappingCache(size_t capacity_bytes) : capacity_(capacity_bytes) {}
+
+    MappingCache(const MappingCache&) = delete;
+    MappingCache& operator=(const MappingCache&) = delete;
+
+    // The current mapping of a file, mapped now if there is none or the file
+    // changed. nullptr when it can't be mapped (missing, empty, ...).
+    Ref get(const std::string& path) {
+        struct stat sb;
+        if (stat(path.c_str(), &sb) != 0) return nullptr;
+        Key key{sb.st_dev, sb.st_ino};
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it != index_.end()) {
+                if (current(*it->second->mapping, sb)) {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    hits_++;
+                    return it->second->mapping;
+                }
+                remove(it);
+            }
+        }
+
+        // Mapped without the lock, whoever inserts first wins a race
+        misses_++;
+        Ref mapping = map(path, sb);
+        if (!mapping || mapping->size > capacity_) return mapping;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            if (current(*it->second->mapping, sb)) return it->second->mapping;
+            remove(it);
+        }
+        while (used_ + mapping->size > capacity_) {
+            remove(index_.find(lru_.back().key));
+            evictions_++;
+        }
+        used_ += mapping->size;
+        lru_.push_front(Entry{key, mapping});
+        index_.emplace(key, lru_.begin());
+        return mapping;
+    }
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t evictions() const { return evictions_; }
+
+    size_t mapped_bytes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return used_;
+    }
+
+private:
+    using Key = std::pair<dev_t, ino_t>;
+
+    struct Entry {
+        Key key;
+        Ref mapping;
+    };
+
+    static bool current(const Mapping& mapping, const struct stat& sb) {
+        return mapping.size == (size_t)sb.st_size &&
+               mapping.mtime.tv_sec == sb.st_mtim.tv_sec &&
+               mapping.mtime.tv_nsec == sb.st_mtim.tv_nsec;
+    }
+
+    static Ref map(const std::string& path, const struct stat& sb) {
+        if (sb.st_size == 0) return nullptr;
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        void* data = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return nullptr;
+
+        auto mapping = std::make_shared<Mapping>();
+        mapping->data = static_cast<const char*>(data);
+        mapping->size = sb.st_size;
+        mapping->mtime = sb.st_mtim;
+        return mapping;
+    }
+
+    void remove(std::map<Key, std::list<Entry>::iterator>::iterator it) {
+        used_ -= it->second->mapping->size;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    size_t capacity_;
+    std::mutex mutex_;
+    std::list<Entry> lru_; // most recently used first
+    std::map<Key, std::list<Entry>::iterator> index_;
+    size_t used_ = 0;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
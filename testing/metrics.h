@@ -0,0 +1,217 @@
+#pragma once
+
+// Per-request metrics, collected without locks on the request path.
+//
+// Every thread that records gets its own single-producer ring of samples,
+// registered once on first use. Recording is a couple of relaxed/acquire-
+// release atomics and a copy into the ring, so worker threads never contend
+// with each other or with the reader. Readers drain all rings under a mutex
+// that only readers take. When a ring is full (nobody drained it for a
+// while) new samples are dropped and counted instead of blocking.
+//
+// MetricsSummary accumulates drained samples into per-method counters and
+// histograms and renders them in the Prometheus text exposition format.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Metrics tracking
+struct Metrics {
+    const char* method; // string literal, so recording doesn't allocate
+    long long duration_us;
+    size_t file_size;
+    double throughput_mbps;
+};
+
+class MetricsRecorder {
+public:
+    // Called from any thread, never blocks
+    void record(const Metrics& sample) {
+        Ring* ring = thread_ring();
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        if (tail - ring->head.load(std::memory_order_acquire) >= RING_SIZE) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring->samples[tail % RING_SIZE] = sample;
+        ring->tail.store(tail + 1, std::memory_order_release);
+    }
+
+    // Hand every sample recorded since the last drain to consumer
+    template <typename Consumer>
+    void drain(Consumer&& consumer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& ring : rings_) {
+            uint64_t head = ring->head.load(std::memory_order_relaxed);
+            uint64_t tail = ring->tail.load(std::memory_order_acquire);
+            for (; head != tail; head++) {
+                consumer(ring->samples[head % RING_SIZE]);
+            }
+            ring->head.store(head, std::memory_order_release);
+        }
+    }
+
+    // Samples lost to full rings so far
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t RING_SIZE = 4096;
+
+    struct Ring {
+        // Producer and consumer indices on their own cache lines
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        Metrics samples[RING_SIZE];
+    };
+
+    // Rings are owned by the recorder and outlive their threads, a sample
+    // recorded right before a thread exits is still drained
+    Ring* thread_ring() {
+        thread_local std::vector<std::pair<MetricsRecorder*, Ring*>> rings;
+        for (auto& ring : rings) {
+            if (ring.first == this) return ring.second;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.emplace_back(new Ring());
+        rings.emplace_back(this, rings_.back().get());
+        return rings.back().second;
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Cumulative totals of every sample added so far, by method
+class MetricsSummary {
+public:
+    void add(const Metrics& sample) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        MethodStats& stats = methods_[sample.method];
+        stats.count++;
+        stats.bytes += sample.file_size;
+        stats.latency.observe(sample.duration_us / 1000000.0);
+        stats.throughput.observe(sample.throughput_mbps);
+    }
+
+    // Append every method's counters and histograms in Prometheus text format
+    void write_prometheus(std::string& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        out += "# HELP zc_requests_total Requests served, by method.\n";
+        out += "# TYPE zc_requests_total counter\n";
+        for (auto& method : methods_) {
+            write_sample(out, "zc_requests_total", method.first, nullptr, method.second.count);
+        }
+
+        out += "# HELP zc_response_bytes_total Body bytes sent, by method.\n";
+        out += "# TYPE zc_response_bytes_total counter\n";
+        for (auto& method : methods_) {
+            write_sample(out, "zc_response_bytes_total", method.first, nullptr, method.second.bytes);
+        }
+
+        out += "# HELP zc_request_duration_seconds Time to serve a request, by method.\n";
+        out += "# TYPE zc_request_duration_seconds histogram\n";
+        for (auto& method : methods_) {
+            method.second.latency.write(out, "zc_request_duration_seconds", method.first);
+        }
+
+        out += "# HELP zc_throughput_mbps Per-request throughput in MB/s, by method.\n";
+        out += "# TYPE zc_throughput_mbps histogram\n";
+        for (auto& method : methods_) {
+            method.second.throughput.write(out, "zc_throughput_mbps", method.first);
+        }
+    }
+
+private:
+    template <size_t N>
+    struct Histogram {
+        const std::array<double, N>& bounds;
+        std::array<uint64_t, N> buckets{};
+        uint64_t count = 0;
+        double sum = 0;
+
+        explicit Histogram(const std::array<double, N>& bounds) : bounds(bounds) {}
+
+        void observe(double value) {
+            for (size_t i = 0; i < N; i++) {
+                if (value <= bounds[i]) {
+                    buckets[i]++;
+                    break;
+                }
+            }
+            count++;
+            sum += value;
+        }
+
+        // Prometheus buckets are cumulative, each counts everything <= le
+        void write(std::string& out, const char* name, const std::string& method) const {
+            std::string bucket = std::string(name) + "_bucket";
+            char le[32];
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < N; i++) {
+                cumulative += buckets[i];
+                snprintf(le, sizeof(le), "%g", bounds[i]);
+                write_sample(out, bucket.c_str(), method, le, cumulative);
+            }
+            write_sample(out, bucket.c_str(), method, "+Inf", count);
+
+            char value[32];
+            snprintf(value, sizeof(value), "%.6f", sum);
+            write_labels(out, (std::string(name) + "_sum").c_str(), method, nullptr);
+            out += value;
+            out += '\n';
+            write_sample(out, (std::string(name) + "_count").c_str(), method, nullptr, count);
+        }
+    };
+
+    static constexpr std::array<double, 12> LATENCY_BOUNDS = {
+        0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+    static constexpr std::array<double, 10> THROUGHPUT_BOUNDS = {
+        10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000};
+
+    struct MethodStats {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        Histogram<LATENCY_BOUNDS.size()> latency{LATENCY_BOUNDS};
+        Histogram<THROUGHPUT_BOUNDS.size()> throughput{THROUGHPUT_BOUNDS};
+    };
+
+    static void write_labels(std::string& out, const char* name,
+                             const std::string& method, const char* le) {
+        out += name;
+        out += "{method=\"";
+        for (char c : method) {
+            if (c == '\\' || c == '"') out += '\\';
+            out += c;
+        }
+        out += '"';
+        if (le) {
+            out += ",le=\"";
+            out += le;
+            out += '"';
+        }
+        out += "} ";
+    }
+
+    static void write_sample(std::string& out, const char* name, const std::string& method,
+                             const char* le, uint64_t value) {
+        write_labels(out, name, method, le);
+        out += std::to_string(value);
+        out += '\n';
+    }
+
+    std::mutex mutex_;
+    // Ordered so that a scrape lists methods the same way every time
+    std::map<std::string, MethodStats> methods_;
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+// DRAM cache for hot video segments.
+//
+// Segments are keyed by (path, offset) and spread over independently locked
+// shards. Each shard keeps an LRU list bounded by bytes and a TinyLFU style
+// count-min sketch of recent accesses: a new segment only pushes out the LRU
+// victim when it has been requested more often than the victim, so a burst of
+// one-hit-wonder segments can't flush the segments everyone is watching.
+//
+// Entries are handed out as shared_ptr, a response keeps its segment pinned
+// in memory until it has been written even if the cache evicts it meanwhile.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SegmentCache {
+public:
+    using Segment = std::shared_ptr<const std::string>;
+
+    SegmentCache(size_t capacity_bytes, size_t shard_count = 16)
+        : shards_(shard_count) {
+        for (auto& shard : shards_) {
+            shard.capacity = capacity_bytes / shard_count;
+        }
+    }
+
+    // Look a segment up and count the access towards its popularity.
+    // Returns nullptr on a miss.
+    Segment get(const std::string& path, uint64_t offset) {
+        uint64_t hash = hash_key(path, offset);
+        Shard& shard = shard_for(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        shard.sketch.increment(hash);
+        auto it = shard.index.find(Key{path, offset});
+        if (it == shard.index.end()) {
+            misses_++;
+            return nullptr;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        hits_++;
+        return it->second->data;
+    }
+
+    // Whether a segment is cached, without counting it as an access
+    bool contains(const std::string& path, uint64_t offset) {
+        Shard& shard = shard_for(hash_key(path, offset));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.index.count(Key{path, offset}) > 0;
+    }
+
+    // Whether a segment of this size would be let in right now. Lets the
+    // caller skip reading one-hit wonders into memory at all and stream them
+    // from the SSD instead.
+    bool would_admit(const std::string& path, uint64_t offset, size_t size) {
+        uint64_t hash = hash_key(path, offset);
+        Shard& shard = shard_for(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return admissible(shard, hash, size);
+    }
+
+    // Insert a segment, evicting colder ones if needed. Returns false if the
+    // admission policy rejected it.
+    bool put(const std::string& path, uint64_t offset, Segment data) {
+        uint64_t hash = hash_key(path, offset);
+        Shard& shard = shard_for(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        Key key{path, offset};
+        auto existing = shard.index.find(key);
+        if (existing != shard.index.end()) {
+            shard.used -= existing->second->data->size();
+            shard.lru.erase(existing->second);
+            shard.index.erase(existing);
+        }
+
+        if (!admissible(shard, hash, data->size())) {
+            rejections_++;
+            return false;
+        }
+
+        while (shard.used + data->size() > shard.capacity) {
+            Entry& victim = shard.lru.back();
+            shard.used -= victim.data->size();
+            shard.index.erase(victim.key);
+            shard.lru.pop_back();
+            evictions_++;
+        }
+
+        shard.used += data->size();
+        shard.lru.push_front(Entry{key, hash, std::move(data)});
+        shard.index.emplace(std::move(key), shard.lru.begin());
+        return true;
+    }
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t evictions() const { return evictions_; }
+    uint64_t rejections() const { return rejections_; }
+
+    size_t size_bytes() {
+        size_t total = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.used;
+        }
+        return total;
+    }
+
+private:
+    struct Key {
+        std::string path;
+        uint64_t offset;
+
+        bool operator==(const Key& other) const {
+            return offset == other.offset && path == other.path;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return hash_key(key.path, key.offset);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        uint64_t hash;
+        Segment data;
+    };
+
+    // Count-min sketch with 4-bit saturating counters, halved every
+    // SAMPLE_SIZE increments so that popularity ages out.
+    class FrequencySketch {
+    public:
+        FrequencySketch() : counters_(DEPTH * WIDTH, 0) {}
+
+        void increment(uint64_t hash) {
+            for (size_t row = 0; row < DEPTH; row++) {
+                uint8_t& counter = counters_[row * WIDTH + index(hash, row)];
+                if (counter < MAX_COUNT) counter++;
+            }
+            if (++additions_ >= SAMPLE_SIZE) age();
+        }
+
+        uint8_t estimate(uint64_t hash) const {
+            uint8_t count = MAX_COUNT;
+            for (size_t row = 0; row < DEPTH; row++) {
+                count = std::min(count, counters_[row * WIDTH + index(hash, row)]);
+            }
+            return count;
+        }
+
+    private:
+        static constexpr size_t DEPTH = 4;
+        static constexpr size_t WIDTH = 4096; // per shard, power of two
+        static constexpr uint8_t MAX_COUNT = 15;
+        static constexpr size_t SAMPLE_SIZE = 10 * WIDTH;
+
+        static size_t index(uint64_t hash, size_t row) {
+            // Double hashing: h1 + row * h2 gives DEPTH independent-enough rows
+            uint64_t h1 = hash;
+            uint64_t h2 = (hash >> 32) | 1;
+            return (h1 + row * h2) & (WIDTH - 1);
+        }
+
+        void age() {
+            for (auto& counter : counters_) counter >>= 1;
+            additions_ /= 2;
+        }
+
+        std::vector<uint8_t> counters_;
+        size_t additions_ = 0;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        FrequencySketch sketch;
+        size_t used = 0;
+        size_t capacity = 0;
+    };
+
+    static uint64_t hash_key(const std::string& path, uint64_t offset) {
+        uint64_t h = std::hash<std::string>()(path) ^ (offset * 0x9E3779B97F4A7C15ULL);
+        // splitmix64 finalizer, std::hash is the identity for integers on libstdc++
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    // The shard comes from the high bits of the hash: the sketch indexes with
+    // the low ones, and taking both from the same bits would leave each
+    // shard's sketch only a fraction of its counters.
+    Shard& shard_for(uint64_t hash) {
+        return shards_[((hash >> 32) * shards_.size()) >> 32];
+    }
+
+    // TinyLFU: there is room, or the candidate is more popular than every
+    // entry it would push out.
+    bool admissible(Shard& shard, uint64_t hash, size_t size) const {
+        if (size > shard.capacity) return false;
+        if (shard.used + size <= shard.capacity) return true;
+
+        uint8_t candidate = shard.sketch.estimate(hash);
+        size_t freed = 0;
+        for (auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it) {
+            if (shard.sketch.estimate(it->hash) >= candidate) return false;
+            freed += it->data->size();
+            if (shard.used - freed + size <= shard.capacity) return true;
+        }
+        return false;
+    }
+
+    std::vector<Shard> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> rejections_{0};
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+// Prefetches the HLS segments a player is about to ask for.
+//
+// Players fetch segments of a rendition in order, so after segment N of a
+// session the next DEPTH segments are queued for a background thread that
+// resolves them through the HlsIndex and hands them to a fetch callback
+// (filling the DRAM cache or the page cache). A session that keeps playing in
+// order only ever adds the one new segment at the end of its window, a seek
+// starts a new window. Segments already queued by another session aren't
+// queued twice, and when the queue is full new work is dropped rather than
+// letting prefetching fall further behind playback. Sessions are kept in the
+// order they last played, so forgetting idle ones only ever looks at the
+// oldest.
+
+#include "hls_index.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+class SegmentPrefetcher {
+public:
+    using Fetch = std::function<void(const HlsIndex::Segment& segment)>;
+
+    SegmentPrefetcher(HlsIndex& index, Fetch fetch, size_t depth = 3, size_t max_queue = 64)
+        : index_(index), fetch_(std::move(fetch)), depth_(depth), max_queue_(max_queue),
+          worker_([this] { run(); }) {}
+
+    ~SegmentPrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+
+    SegmentPrefetcher(const SegmentPrefetcher&) = delete;
+    SegmentPrefetcher& operator=(const SegmentPrefetcher&) = delete;
+
+    // A session (one player, see the caller for how it is told apart) was
+    // just sent segment index of a rendition
+    void played(const std::string& session, const std::string& rendition, size_t index) {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto inserted = sessions_.emplace(session + '\n' + rendition, Session());
+        Session& state = inserted.first->second;
+        if (inserted.second) {
+            state.order = order_.insert(order_.end(), &inserted.first->first);
+        } else {
+            order_.splice(order_.end(), order_, state.order);
+        }
+        size_t from = index + 1;
+        // Still inside the window queued last time, only extend it
+        if (state.last_seen != std::chrono::steady_clock::time_point() &&
+            index > state.last_index && index < state.window_end) {
+            from = state.window_end;
+        }
+        state.last_index = index;
+        state.window_end = index + 1 + depth_;
+        state.last_seen = now;
+
+        for (size_t next = from; next < state.window_end; next++) {
+            Job job{rendition, next};
+            if (pending_.count(job)) continue;
+            if (queue_.size() >= max_queue_) {
+                dropped_++;
+                continue;
+            }
+            pending_.insert(job);
+            queue_.push_back(std::move(job));
+            queued_++;
+        }
+        expire(now);
+        wake_.notify_one();
+    }
+
+    uint64_t queued() const { return queued_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    // Sessions idle for longer than this are forgotten
+    static constexpr std::chrono::seconds SESSION_TIMEOUT{60};
+
+    struct Session {
+        size_t last_index = 0;
+        size_t window_end = 0;
+        std::chrono::steady_clock::time_point last_seen;
+        std::list<const std::string*>::iterator order;
+    };
+
+    using Job = std::pair<std::string, size_t>;
+
+    // Drop idle sessions from the least recently played end, stopping at the
+    // first one still playing
+    void expire(std::chrono::steady_clock::time_point now) {
+        while (!order_.empty()) {
+            auto it = sessions_.find(*order_.front());
+            if (now - it->second.last_seen <= SESSION_TIMEOUT) break;
+            order_.pop_front();
+            sessions_.erase(it);
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+
+            Job job = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+
+            HlsIndex::Segment segment;
+            if (index_.segment(job.first, job.second, segment)) fetch_(segment);
+
+            lock.lock();
+            pending_.erase(job);
+        }
+    }
+
+    HlsIndex& index_;
+    Fetch fetch_;
+    size_t depth_;
+    size_t max_queue_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::unordered_map<std::string, Session> sessions_;
+    std::list<const std::string*> order_; // keys of sessions_, least recently played first
+    std::deque<Job> queue_;
+    std::set<Job> pending_; // queued or being fetched
+    std::atomic<uint64_t> queued_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    // Last, so the thread only starts once everything above exists
+    std::thread worker_;
+};
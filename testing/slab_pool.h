@@ -0,0 +1,147 @@
+#pragma once
+
+// Pool of fixed-size, 4KB-aligned slabs for O_DIRECT reads.
+//
+// All slabs come out of one region that is mapped and faulted in once at
+// startup (on hugepages when asked and available), so a read never pays for
+// an allocation or page faults, memory used for direct I/O is bounded by the
+// pool size, and the whole region can be registered with io_uring as a
+// single fixed buffer. The constructing thread faults the region in, so with
+// the default first-touch policy it lands on that thread's NUMA node.
+//
+// Each thread keeps a small freelist of its own and only touches the shared
+// list, under a mutex, to move slabs over in batches. Pools are meant to live
+// as long as the program: a thread hands its cached slabs back when it exits.
+
+#include <sys/mman.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class SlabPool {
+public:
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr size_t HUGEPAGE_SIZE = 2 * 1024 * 1024;
+
+    struct Releaser {
+        SlabPool* pool;
+        void operator()(char* slab) const { pool->release(slab); }
+    };
+    using Slab = std::unique_ptr<char, Releaser>;
+
+    SlabPool(size_t slab_size, size_t slab_count, bool hugepages = false)
+        : slab_size_(round_up(slab_size, ALIGNMENT)),
+          slab_count_(slab_count) {
+        region_size_ = slab_size_ * slab_count_;
+        void* region = MAP_FAILED;
+        if (hugepages) {
+            region_size_ = round_up(region_size_, HUGEPAGE_SIZE);
+            region = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            hugepages_ = region != MAP_FAILED;
+        }
+        if (region == MAP_FAILED) {
+            region = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (region == MAP_FAILED) {
+                region_size_ = slab_count_ = 0;
+                return;
+            }
+            // No reserved hugepages, transparent ones are the next best thing
+            if (hugepages) madvise(region, region_size_, MADV_HUGEPAGE);
+            // Fault everything in now rather than on the first reads
+#ifdef MADV_POPULATE_WRITE
+            if (madvise(region, region_size_, MADV_POPULATE_WRITE) != 0)
+#endif
+            {
+                for (size_t offset = 0; offset < region_size_; offset += ALIGNMENT) {
+                    static_cast<char*>(region)[offset] = 0;
+                }
+            }
+        }
+        region_ = static_cast<char*>(region);
+
+        free_.reserve(slab_count_);
+        for (size_t i = slab_count_; i > 0; i--) {
+            free_.push_back(region_ + (i - 1) * slab_size_);
+        }
+    }
+
+    ~SlabPool() {
+        if (region_) munmap(region_, region_size_);
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    // A free slab, or an empty handle when every slab is in use
+    Slab acquire() {
+        std::vector<char*>& cache = thread_cache();
+        if (cache.empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t count = std::min(BATCH, free_.size());
+            cache.insert(cache.end(), free_.end() - count, free_.end());
+            free_.resize(free_.size() - count);
+        }
+        if (cache.empty()) return Slab(nullptr, Releaser{this});
+
+        char* slab = cache.back();
+        cache.pop_back();
+        return Slab(slab, Releaser{this});
+    }
+
+    size_t slab_size() const { return slab_size_; }
+    size_t slab_count() const { return slab_count_; }
+    bool hugepages() const { return hugepages_; }
+
+    // The backing region, for registering with io_uring
+    char* region() const { return region_; }
+    size_t region_size() const { return region_size_; }
+
+private:
+    // Slabs moved between a thread's cache and the shared list at once
+    static constexpr size_t BATCH = 8;
+
+    struct ThreadCaches {
+        std::unordered_map<SlabPool*, std::vector<char*>> caches;
+
+        ~ThreadCaches() {
+            for (auto& cache : caches) cache.first->give_back(cache.second, cache.second.size());
+        }
+    };
+
+    static size_t round_up(size_t size, size_t alignment) {
+        return ((size + alignment - 1) / alignment) * alignment;
+    }
+
+    std::vector<char*>& thread_cache() {
+        thread_local ThreadCaches threads;
+        return threads.caches[this];
+    }
+
+    void release(char* slab) {
+        if (!slab) return;
+        std::vector<char*>& cache = thread_cache();
+        cache.push_back(slab);
+        // Slabs acquired on one thread and released on another pile up here,
+        // hand the surplus back so the other threads can have them
+        if (cache.size() > 2 * BATCH) give_back(cache, BATCH);
+    }
+
+    void give_back(std::vector<char*>& cache, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.insert(free_.end(), cache.end() - count, cache.end());
+        cache.resize(cache.size() - count);
+    }
+
+    size_t slab_size_;
+    size_t slab_count_;
+    size_t region_size_ = 0;
+    char* region_ = nullptr;
+    bool hugepages_ = false;
+
+    std::mutex mutex_;
+    std::vector<char*> free_;
+};
@@ -0,0 +1,537 @@
+#pragma once
+
+// io_uring read engine for the SSD path.
+//
+// One ring per io_context thread. Reads are O_DIRECT, aligned, and go into
+// slabs of a SlabPool whose region is registered with the ring up front, as
+// are the files (READ_FIXED + IOSQE_FIXED_FILE), so the kernel neither maps
+// the buffer nor looks up the fd per request. Up to queue_depth reads are kept in flight to actually use
+// the SSD's internal parallelism, and completions are signalled through an
+// eventfd watched by the io_context, so the worker thread never sleeps on the
+// device: it goes back to serving other connections until data is there.
+//
+// UringFileSource streams a file through a ring as a crow response body.
+//
+// Talks to the kernel through the raw syscalls so the build needs nothing
+// beyond the kernel headers (no liburing).
+
+#include "crow_all.h"
+#include "slab_pool.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef CROW_USE_BOOST
+namespace asio = boost::asio;
+#endif
+
+class UringReader {
+public:
+    // Called with the number of bytes read, or -errno
+    using Completion = std::function<void(int result)>;
+
+    static constexpr size_t ALIGNMENT = SlabPool::ALIGNMENT;
+
+    UringReader(asio::io_context& io_context,
+                SlabPool& pool,
+                unsigned queue_depth = 32,
+                unsigned max_files = 64)
+        : queue_depth_(queue_depth),
+          pool_(pool),
+          completions_(queue_depth),
+          files_(max_files, -1),
+          io_context_(io_context),
+          event_(io_context),
+          retry_timer_(io_context) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd_ = syscall(__NR_io_uring_setup, queue_depth_, &params);
+        if (ring_fd_ < 0) return;
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) return;
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cq_ring_ = sq_ring_;
+        } else {
+            cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED) return;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+        if (sqes_ == MAP_FAILED) return;
+
+        char* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // The whole slab region is a single registered buffer, READ_FIXED
+        // can target any slab inside it
+        if (!pool_.region()) return;
+        iovec region;
+        region.iov_base = pool_.region();
+        region.iov_len = pool_.region_size();
+        fixed_buffers_ = syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS,
+                                 &region, 1) == 0;
+
+        // Sparse fixed file table, slots are filled in by register_file()
+        fixed_files_ = syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES,
+                               files_.data(), files_.size()) == 0;
+
+        event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd_ < 0) return;
+        if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_EVENTFD, &event_fd_, 1) != 0) return;
+        event_.assign(event_fd_);
+
+        for (unsigned i = queue_depth_; i > 0; i--) free_slots_.push_back(i - 1);
+        ok_ = true;
+    }
+
+    ~UringReader() {
+        // Dropping the callbacks of reads still queued or in flight may drop
+        // the last reference to their sources, which unregister their files:
+        // do it while the file table and the ring are still there
+        completions_.clear();
+        slot_waiters_.clear();
+        unsubmitted_.clear();
+        *alive_ = false;
+        crow::error_code ec;
+        if (event_.is_open()) event_.close(ec); // also closes event_fd_
+        else if (event_fd_ >= 0) close(event_fd_);
+        if (sqes_ && sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_ && sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+        if (ring_fd_ >= 0) close(ring_fd_);
+    }
+
+    UringReader(const UringReader&) = delete;
+    UringReader& operator=(const UringReader&) = delete;
+
+    // Whether the kernel gave us a working ring
+    bool ok() const { return ok_; }
+    unsigned queue_depth() const { return queue_depth_; }
+    unsigned in_flight() const { return in_flight_; }
+    SlabPool& pool() { return pool_; }
+    asio::io_context& io_context() { return io_context_; }
+
+    // False once the ring is destroyed. A thread's ring goes before its
+    // io_context, whose abandoned handlers may still hold sources of it.
+    std::shared_ptr<const bool> alive() const { return alive_; }
+
+    // Whether another read can be queued right now
+    bool has_free_slot() const { return ok_ && !free_slots_.empty(); }
+
+    // Run `ready` once completions have freed slots again. Waiters are woken
+    // in the order they asked, as long as there are free slots left.
+    void when_slot_free(std::function<void()> ready) {
+        slot_waiters_.push_back(std::move(ready));
+    }
+
+    // Install fd in the ring's fixed file table. Returns the handle to pass
+    // to queue_read(): a slot, or the fd itself if files aren't registered.
+    int register_file(int fd) {
+        if (!fixed_files_) return fd;
+        for (unsigned slot = 0; slot < files_.size(); slot++) {
+            if (files_[slot] != -1) continue;
+            io_uring_files_update update;
+            memset(&update, 0, sizeof(update));
+            update.offset = slot;
+            update.fds = reinterpret_cast<uint64_t>(&fd);
+            if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1) != 1) {
+                return -1;
+            }
+            files_[slot] = fd;
+            return slot;
+        }
+        return -1;
+    }
+
+    void unregister_file(int handle) {
+        if (!fixed_files_ || handle < 0 || handle >= (int)files_.size()) return;
+        int none = -1;
+        io_uring_files_update update;
+        memset(&update, 0, sizeof(update));
+        update.offset = handle;
+        update.fds = reinterpret_cast<uint64_t>(&none);
+        syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1);
+        files_[handle] = -1;
+    }
+
+    // Queue a read of `length` bytes at `offset` into `buffer`, a slab of the
+    // pool. Nothing reaches the kernel until submit(), so a batch of reads
+    // costs a single io_uring_enter. Returns false when queue_depth reads are
+    // already outstanding, or the ring failed.
+    bool queue_read(int file, char* buffer, uint64_t offset, size_t length, Completion done) {
+        if (!has_free_slot()) return false;
+        unsigned index = free_slots_.back();
+        free_slots_.pop_back();
+
+        unsigned tail = *sq_tail_;
+        unsigned slot = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[slot];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = fixed_buffers_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = file;
+        sqe->flags = fixed_files_ ? IOSQE_FIXED_FILE : 0;
+        sqe->off = offset;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = length;
+        sqe->buf_index = 0;
+        sqe->user_data = index;
+        sq_array_[slot] = slot;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+        completions_[index] = std::move(done);
+        unsubmitted_.push_back(index);
+        return true;
+    }
+
+    int submit() {
+        if (unsubmitted_.empty()) return 0;
+        int submitted = syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_.size(), 0, 0, nullptr, 0);
+        if (submitted > 0) {
+            // The kernel consumes submissions in queue order
+            unsubmitted_.erase(unsubmitted_.begin(), unsubmitted_.begin() + submitted);
+            in_flight_ += submitted;
+        } else if (submitted < 0 && (errno == EAGAIN || errno == EBUSY || errno == EINTR)) {
+            // Out of kernel resources or the completion queue is full: reaping
+            // completions retries, without any outstanding try again shortly
+            if (in_flight_ == 0) retry_submit();
+        } else if (submitted < 0) {
+            fail_unsubmitted(-errno);
+        }
+        wait_for_completions();
+        return submitted;
+    }
+
+private:
+    void retry_submit() {
+        if (retry_scheduled_) return;
+        retry_scheduled_ = true;
+        retry_timer_.expires_after(std::chrono::milliseconds(1));
+        retry_timer_.async_wait([this](const crow::error_code& ec) {
+            if (ec) return;
+            retry_scheduled_ = false;
+            submit();
+        });
+    }
+
+    // The ring can't take submissions anymore: fail every read that didn't
+    // reach the kernel, those that did still complete normally. The
+    // completions run from the io_context, not inside the caller's submit().
+    void fail_unsubmitted(int error) {
+        ok_ = false;
+        for (unsigned index : unsubmitted_) {
+            Completion done = std::move(completions_[index]);
+            completions_[index] = nullptr;
+            free_slots_.push_back(index);
+            if (done) asio::post(io_context_, [done, error] { done(error); });
+        }
+        unsubmitted_.clear();
+        slot_waiters_.clear();
+    }
+
+    void wait_for_completions() {
+        if (waiting_ || in_flight_ == 0) return;
+        waiting_ = true;
+        event_.async_wait(asio::posix::stream_descriptor::wait_read,
+                          [this](const crow::error_code& ec) {
+            waiting_ = false;
+            if (ec) return;
+            uint64_t count;
+            if (read(event_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) return;
+            reap();
+            submit(); // completion handlers usually queue the next reads
+            wait_for_completions();
+        });
+    }
+
+    void reap() {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+            unsigned index = cqe->user_data;
+            int result = cqe->res;
+            head++;
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            in_flight_--;
+
+            Completion done = std::move(completions_[index]);
+            completions_[index] = nullptr;
+            free_slots_.push_back(index);
+            if (done) done(result);
+        }
+
+        // Waiters that get no slot this time keep their place in front of any
+        // that asked again meanwhile
+        std::deque<std::function<void()>> waiters;
+        waiters.swap(slot_waiters_);
+        while (!waiters.empty() && has_free_slot()) {
+            auto ready = std::move(waiters.front());
+            waiters.pop_front();
+            ready();
+        }
+        slot_waiters_.insert(slot_waiters_.begin(), std::make_move_iterator(waiters.begin()),
+                             std::make_move_iterator(waiters.end()));
+    }
+
+    unsigned queue_depth_;
+    SlabPool& pool_;
+    bool ok_ = false;
+    bool fixed_buffers_ = false;
+    bool fixed_files_ = false;
+    bool waiting_ = false;
+    bool retry_scheduled_ = false;
+
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::vector<unsigned> free_slots_;
+    std::vector<Completion> completions_;
+    std::vector<int> files_;
+    std::deque<unsigned> unsubmitted_; // slots queued but not yet taken by the kernel
+    std::deque<std::function<void()>> slot_waiters_;
+    unsigned in_flight_ = 0;
+
+    asio::io_context& io_context_;
+    int event_fd_ = -1;
+    asio::posix::stream_descriptor event_;
+    asio::steady_timer retry_timer_;
+    std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+// Response body read ahead through a UringReader: up to `window` slab-sized
+// reads run ahead of the socket, and the slabs are handed to the connection
+// in file order as it asks for them. Memory per response stays at `window`
+// slabs however large the file is, and slabs go back to the pool as soon as
+// they have been written.
+class UringFileSource : public crow::body_source,
+                        public std::enable_shared_from_this<UringFileSource> {
+public:
+    // nullptr if the file can't be opened or the ring has no room for it
+    static std::shared_ptr<UringFileSource> open(UringReader& ring, const std::string& filepath,
+                                                 unsigned window = 8) {
+        int fd = ::open(filepath.c_str(), O_RDONLY | O_DIRECT);
+        bool direct = fd >= 0;
+        if (fd < 0) {
+            // O_DIRECT might fail (e.g. tmpfs), fallback to regular
+            fd = ::open(filepath.c_str(), O_RDONLY);
+        }
+        struct stat sb;
+        if (fd < 0 || fstat(fd, &sb) < 0) {
+            if (fd >= 0) close(fd);
+            return nullptr;
+        }
+        int file = ring.register_file(fd);
+        if (file < 0) {
+            close(fd);
+            return nullptr;
+        }
+        return std::shared_ptr<UringFileSource>(new UringFileSource(ring, fd, file, sb.st_size, window, direct));
+    }
+
+    ~UringFileSource() {
+        if (*ring_alive_) ring_.unregister_file(file_);
+        close(fd_);
+    }
+
+    uint64_t size() const { return size_; }
+
+    void next(chunk_handler handler) override {
+        auto self = shared_from_this(); // handing over the last chunk may drop the connection's reference
+        waiting_ = std::move(handler);
+        deliver();
+        fill();
+    }
+
+private:
+    struct Chunk {
+        SlabPool::Slab slab;
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t filled = 0;
+        bool ready = false;
+        bool failed = false;
+    };
+
+    UringFileSource(UringReader& ring, int fd, int file, uint64_t size, unsigned window, bool direct)
+        : ring_(ring), ring_alive_(ring.alive()), fd_(fd), file_(file), size_(size), window_(window), direct_(direct) {}
+
+    // Keep the read-ahead window full, if neither the ring nor the pool has
+    // anything to spare and nothing is in flight, try again shortly
+    void fill() {
+        bool queued = false;
+        bool failed = false;
+        // Reads that found the ring full go first, they are ahead in the file
+        while (!pending_.empty() && ring_.has_free_slot()) {
+            Chunk* chunk = pending_.front();
+            pending_.pop_front();
+            failed |= !read(chunk);
+            queued = true;
+        }
+        while (pending_.empty() && chunks_.size() < window_ && next_offset_ < size_ && ring_.has_free_slot()) {
+            SlabPool::Slab slab = ring_.pool().acquire();
+            if (!slab) break;
+            std::unique_ptr<Chunk> chunk(new Chunk{std::move(slab)});
+            chunk->offset = next_offset_;
+            chunk->length = std::min<uint64_t>(ring_.pool().slab_size(), size_ - next_offset_);
+            next_offset_ += chunk->length;
+            failed |= !read(chunk.get());
+            chunks_.push_back(std::move(chunk));
+            queued = true;
+        }
+        if (!ring_.ok() && !pending_.empty()) {
+            for (Chunk* chunk : pending_) chunk->failed = true;
+            pending_.clear();
+            failed = true;
+        }
+
+        if (!pending_.empty()) wait_for_slot();
+        if (queued) ring_.submit();
+        if (failed) {
+            deliver();
+        } else if (!queued && chunks_.empty() && next_offset_ < size_ && waiting_ && !retry_scheduled_) {
+            retry_scheduled_ = true;
+            auto self = shared_from_this();
+            auto timer = std::make_shared<asio::steady_timer>(ring_.io_context(), std::chrono::milliseconds(1));
+            timer->async_wait([self, timer](const crow::error_code&) {
+                self->retry_scheduled_ = false;
+                self->fill();
+            });
+        }
+    }
+
+    // Queue the rest of a chunk. A chunk the ring has no slot for waits in
+    // pending_; returns false once the ring has failed, the chunk has then
+    // failed too.
+    bool read(Chunk* chunk) {
+        if (!ring_.ok()) {
+            chunk->failed = true;
+            return false;
+        }
+        // O_DIRECT wants the length rounded up to the block size, the tail of
+        // the file simply comes back as a short read
+        size_t remaining = chunk->length - chunk->filled;
+        size_t aligned = ((remaining + UringReader::ALIGNMENT - 1) / UringReader::ALIGNMENT) * UringReader::ALIGNMENT;
+        auto self = shared_from_this();
+        bool queued = ring_.queue_read(file_, chunk->slab.get() + chunk->filled, chunk->offset + chunk->filled,
+                                       std::min(aligned, ring_.pool().slab_size() - chunk->filled),
+                                       [self, chunk](int result) {
+            if (result <= 0) {
+                chunk->failed = true;
+            } else {
+                chunk->filled += std::min<size_t>(result, chunk->length - chunk->filled);
+                if (chunk->filled < chunk->length && self->direct_ && chunk->filled % UringReader::ALIGNMENT != 0) {
+                    // Short read in the middle of the file that didn't end on
+                    // a block: O_DIRECT can't continue at that offset
+                    chunk->failed = true;
+                } else if (chunk->filled < chunk->length) {
+                    // Short read in the middle of the file, fetch the rest
+                    if (self->read(chunk)) {
+                        if (!self->pending_.empty()) self->wait_for_slot();
+                        return;
+                    }
+                } else {
+                    chunk->ready = true;
+                }
+            }
+            self->deliver();
+            self->fill();
+        });
+        if (!queued) pending_.push_back(chunk);
+        return true;
+    }
+
+    void wait_for_slot() {
+        if (slot_wait_scheduled_) return;
+        slot_wait_scheduled_ = true;
+        auto self = shared_from_this();
+        ring_.when_slot_free([self] {
+            self->slot_wait_scheduled_ = false;
+            self->fill();
+        });
+    }
+
+    // Hand the next chunk in file order to the connection, if it asked for one
+    void deliver() {
+        if (!waiting_) return;
+        if (chunks_.empty()) {
+            if (next_offset_ < size_) return;
+            auto handler = std::move(waiting_);
+            waiting_ = nullptr;
+            handler(true, nullptr, 0, nullptr);
+            return;
+        }
+
+        Chunk& front = *chunks_.front();
+        if (!front.ready && !front.failed) return;
+        auto handler = std::move(waiting_);
+        waiting_ = nullptr;
+        if (front.failed) {
+            handler(false, nullptr, 0, nullptr);
+            return;
+        }
+
+        std::unique_ptr<Chunk> chunk = std::move(chunks_.front());
+        chunks_.pop_front();
+        SlabPool::Releaser releaser = chunk->slab.get_deleter();
+        std::shared_ptr<char> slab(chunk->slab.release(), releaser);
+        handler(true, slab.get(), chunk->length, slab);
+    }
+
+    UringReader& ring_;
+    std::shared_ptr<const bool> ring_alive_;
+    int fd_;
+    int file_;
+    uint64_t size_;
+    unsigned window_;
+    bool direct_;                               // opened with O_DIRECT
+    uint64_t next_offset_ = 0;
+    std::deque<std::unique_ptr<Chunk>> chunks_; // in file order
+    std::deque<Chunk*> pending_;                // in chunks_, waiting for a ring slot
+    chunk_handler waiting_;
+    bool retry_scheduled_ = false;
+    bool slot_wait_scheduled_ = false;
+};
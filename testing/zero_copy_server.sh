@@ -14,14 +14,19 @@ NC='\033[0m' # No Color
 
 # Build the server
 echo -e "${BLUE}[1/4] Building the server...${NC}"
-g++ -std=c++14 zero_copy_test.cpp -o zero_copy_server -lpthread -O3
+g++ -std=c++17 zero_copy_test.cpp -o zero_copy_server -lpthread -O3
 if [ $? -ne 0 ]; then
     echo "Build failed! Make sure you have:"
     echo "  - crow_all.h in the same directory"
-    echo "  - g++ with C++14 support"
+    echo "  - g++ with C++17 support"
     echo "  - pthread library"
     exit 1
 fi
+g++ -std=c++17 load_generator.cpp -o load_generator -lpthread -O3
+if [ $? -ne 0 ]; then
+    echo "Building the load generator failed!"
+    exit 1
+fi
 echo -e "${GREEN}Build successful!${NC}"
 echo ""
 
@@ -41,19 +46,17 @@ echo ""
 
 # Run tests
 echo -e "${BLUE}[3/4] Running performance tests...${NC}"
-echo "Testing each method 3 times for consistency..."
-echo ""
 
-METHODS=("traditional" "mmap" "mmap-willneed" "buffered" "direct")
+METHODS=("traditional" "mmap" "mmap-willneed" "buffered" "direct" "sendfile" "splice" "uring")
+CONNECTIONS=${CONNECTIONS:-4}
+REQUESTS=${REQUESTS:-20}
 
-for method in "${METHODS[@]}"; do
-    echo "Testing: $method"
-    for i in {1..3}; do
-        curl -s "http://localhost:18080/$method" -o /dev/null
-        sleep 0.5
-    done
-    echo ""
-done
+# One phase per method so the server CPU per request can be told apart,
+# results are appended to results.csv to compare runs
+./load_generator --per-method --mix "$(IFS=,; echo "${METHODS[*]}")" \
+    --connections $CONNECTIONS --requests $REQUESTS \
+    --server-pid $SERVER_PID --csv results.csv --json results.json
+echo ""
 
 echo -e "${GREEN}Tests complete!${NC}"
 echo ""
@@ -73,6 +76,11 @@ echo "Test complete! Check the output above for performance metrics."
 echo ""
 echo "Additional testing options:"
 echo "  - Modify FILE_SIZE_MB in the code for larger tests"
+echo "  - CONNECTIONS=64 REQUESTS=1000 $0 for a heavier load"
+echo "  - Mix methods in one run, e.g. 1 mmap for 3 sendfile:"
+echo "    ./load_generator --mix mmap:1,sendfile:3 --connections 64 --requests 1000"
+echo "  - Put .ts files (or directories of pre-cut segments) in media/ and play"
+echo "    http://localhost:18080/hls/master.m3u8"
 echo "  - Use 'ab' (Apache Bench) for concurrent testing:"
 echo "    ab -n 100 -c 10 http://localhost:18080/mmap"
 echo "  - Use 'wrk' for more advanced benchmarking:"
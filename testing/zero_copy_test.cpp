@@ -1,4 +1,11 @@
 #include "crow_all.h"
+#include "hls_index.h"
+#include "mapping_cache.h"
+#include "metrics.h"
+#include "segment_cache.h"
+#include "segment_prefetcher.h"
+#include "slab_pool.h"
+#include "uring_reader.h"
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/sendfile.h>
@@ -7,213 +14,324 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
-// Metrics tracking
-struct Metrics {
-    std::string method;
-    long long duration_us;
-    size_t file_size;
-    double throughput_mbps;
-};
+// Recorded from every worker thread, collected into the summary /metrics
+// serves and the samples the console prints
+MetricsRecorder metrics;
+MetricsSummary metrics_summary;
+std::mutex console_mutex;
+std::vector<Metrics> console_samples; // collected since the last print
+
+// DRAM cache for hot segments, misses are streamed from the SSD with sendfile.
+// One cache per NUMA node, split from CACHE_SIZE_MB: a worker only uses the
+// cache of the node it runs on, so with pinned workers a cached segment was
+// read into that node's memory and is only ever sent from its CPUs
+const size_t SEGMENT_SIZE = 4 * 1024 * 1024; // roughly one HLS segment
+const size_t CACHE_SIZE_MB = 256;
+
+std::vector<std::unique_ptr<SegmentCache>> make_segment_caches() {
+    int nodes = crow::cpu_topology::instance().node_count();
+    std::vector<std::unique_ptr<SegmentCache>> caches;
+    for (int node = 0; node < nodes; node++) {
+        caches.emplace_back(new SegmentCache(CACHE_SIZE_MB * 1024 * 1024 / nodes));
+    }
+    return caches;
+}
+std::vector<std::unique_ptr<SegmentCache>> segment_caches = make_segment_caches();
+
+SegmentCache& local_segment_cache() {
+    return *segment_caches[crow::cpu_topology::instance().current_node()];
+}
+
+// A statistic summed over every node's instance
+template <typename T, typename Stat>
+uint64_t node_total(const std::vector<std::unique_ptr<T>>& instances, Stat stat) {
+    uint64_t total = 0;
+    for (auto& instance : instances) total += stat(*instance);
+    return total;
+}
+
+// Files kept mapped for /mmap and /mmap-willneed, bounded by address space
+const size_t MAPPING_CACHE_MB = 8192;
+MappingCache mapping_cache(MAPPING_CACHE_MB * 1024 * 1024);
+
+// HLS renditions under media/, segments are served like /segment ones
+HlsIndex hls_index("media");
 
-std::vector<Metrics> all_metrics;
+// Aligned buffers for every O_DIRECT read, allocated once up front. One pool
+// per NUMA node, split from SLAB_COUNT and mapped by a thread running on that
+// node, so the pages are faulted in on it and a pinned worker reads into
+// local memory
+const size_t SLAB_SIZE = 1024 * 1024;
+const size_t SLAB_COUNT = 128;
 
-// 1. Traditional Copy Method (Baseline)
+std::vector<std::unique_ptr<SlabPool>> make_slab_pools() {
+    int nodes = crow::cpu_topology::instance().node_count();
+    std::vector<std::unique_ptr<SlabPool>> pools(nodes);
+    for (int node = 0; node < nodes; node++) {
+        std::thread([&pools, node, nodes] {
+            crow::cpu_topology::instance().pin_to_node(node);
+            pools[node].reset(new SlabPool(SLAB_SIZE, std::max<size_t>(SLAB_COUNT / nodes, 8), true));
+        }).join();
+    }
+    return pools;
+}
+std::vector<std::unique_ptr<SlabPool>> slab_pools = make_slab_pools();
+
+SlabPool& local_slab_pool() {
+    return *slab_pools[crow::cpu_topology::instance().current_node()];
+}
+
+// 1. Traditional Copy Method (Baseline) - the whole file is read into a
+// string, which the response then copies out; timed until sent like the rest
 std::string read_file_traditional(const std::string& filepath) {
-    auto start = std::chrono::high_resolution_clock::now();
-    
     std::ifstream file(filepath, std::ios::binary);
     if (!file) return "";
     
-    std::string content((std::istreambuf_iterator<char>(file)),
-                        std::istreambuf_iterator<char>());
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    long long duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    
-    Metrics m;
-    m.method = "Traditional Copy";
-    m.duration_us = duration;
-    m.file_size = content.size();
-    m.throughput_mbps = (content.size() / 1024.0 / 1024.0) / (duration / 1000000.0);
-    all_metrics.push_back(m);
-    
-    return content;
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
 }
 
-// 2. Memory-Mapped File (mmap)
-std::string read_file_mmap(const std::string& filepath) {
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    int fd = open(filepath.c_str(), O_RDONLY);
-    if (fd < 0) return "";
-    
-    struct stat sb;
-    if (fstat(fd, &sb) < 0) {
-        close(fd);
-        return "";
+// 4 & 5. Buffered read / Direct I/O (O_DIRECT) - streamed to the socket a
+// slab at a time instead of being read into one big string first. The
+// connection only pulls the next chunk once the last one has been written,
+// so a single slab is reused for the whole file
+class ReadFileSource : public crow::body_source {
+public:
+    static std::shared_ptr<ReadFileSource> open(const std::string& filepath, bool direct) {
+        int fd = -1;
+        if (direct) fd = ::open(filepath.c_str(), O_RDONLY | O_DIRECT);
+        if (fd < 0) {
+            // O_DIRECT might fail, fallback to regular
+            fd = ::open(filepath.c_str(), O_RDONLY);
+            if (fd < 0) return nullptr;
+        }
+        
+        // O_DIRECT requires aligned buffers
+        SlabPool::Slab buffer = local_slab_pool().acquire();
+        struct stat sb;
+        if (!buffer || fstat(fd, &sb) < 0) {
+            close(fd);
+            return nullptr;
+        }
+        return std::shared_ptr<ReadFileSource>(new ReadFileSource(fd, sb.st_size, std::move(buffer)));
     }
     
-    void* mapped = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (mapped == MAP_FAILED) {
-        close(fd);
-        return "";
+    ~ReadFileSource() {
+        close(fd_);
     }
     
-    // Advise kernel about access pattern
-    madvise(mapped, sb.st_size, MADV_SEQUENTIAL);
+    uint64_t size() const { return size_; }
     
-    std::string content(static_cast<char*>(mapped), sb.st_size);
+    void next(chunk_handler handler) override {
+        if (total_read_ >= size_) {
+            handler(true, nullptr, 0, nullptr);
+            return;
+        }
+        ssize_t bytes_read = read(fd_, buffer_.get(), buffer_.get_deleter().pool->slab_size());
+        if (bytes_read <= 0) {
+            handler(false, nullptr, 0, nullptr);
+            return;
+        }
+        size_t used = std::min<uint64_t>(bytes_read, size_ - total_read_);
+        total_read_ += used;
+        handler(true, buffer_.get(), used, nullptr);
+    }
     
-    munmap(mapped, sb.st_size);
-    close(fd);
+private:
+    ReadFileSource(int fd, uint64_t size, SlabPool::Slab buffer)
+        : fd_(fd), size_(size), buffer_(std::move(buffer)) {}
     
+    int fd_;
+    uint64_t size_;
+    uint64_t total_read_ = 0;
+    SlabPool::Slab buffer_;
+};
+
+// 6 & 7. sendfile / splice - the file never enters userspace, so these are
+// timed end to end: from the handler until the last byte reached the socket
+void record_sent_metrics(const char* method,
+                         std::chrono::high_resolution_clock::time_point start,
+                         size_t bytes_sent) {
     auto end = std::chrono::high_resolution_clock::now();
     long long duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
     
     Metrics m;
-    m.method = "mmap";
+    m.method = method;
     m.duration_us = duration;
-    m.file_size = content.size();
-    m.throughput_mbps = (content.size() / 1024.0 / 1024.0) / (duration / 1000000.0);
-    all_metrics.push_back(m);
-    
-    return content;
+    m.file_size = bytes_sent;
+    m.throughput_mbps = (bytes_sent / 1024.0 / 1024.0) / (duration / 1000000.0);
+    metrics.record(m);
 }
 
-// 3. mmap with MADV_WILLNEED (prefetch hint)
-std::string read_file_mmap_willneed(const std::string& filepath) {
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    int fd = open(filepath.c_str(), O_RDONLY);
-    if (fd < 0) return "";
-    
-    struct stat sb;
-    if (fstat(fd, &sb) < 0) {
-        close(fd);
-        return "";
+// 2 & 3. mmap / mmap with MADV_WILLNEED - the file stays mapped between
+// requests and the response is written straight from the mapping, timed
+// until it was sent. Mapping without the hint leaves every page fault to the
+// socket write, WILLNEED starts reading the whole file in right away
+void send_mapping(crow::response& res, const char* method,
+                  std::chrono::high_resolution_clock::time_point start,
+                  MappingCache::Ref mapping, bool willneed) {
+    if (!mapping) {
+        res.code = 404;
+        res.end();
+        return;
     }
-    
-    void* mapped = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (mapped == MAP_FAILED) {
-        close(fd);
-        return "";
+    if (willneed) {
+        madvise(const_cast<char*>(mapping->data), mapping->size, MADV_WILLNEED);
     }
-    
-    // Prefetch the entire file
-    madvise(mapped, sb.st_size, MADV_WILLNEED);
-    madvise(mapped, sb.st_size, MADV_SEQUENTIAL);
-    
-    std::string content(static_cast<char*>(mapped), sb.st_size);
-    
-    munmap(mapped, sb.st_size);
-    close(fd);
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    long long duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    
-    Metrics m;
-    m.method = "mmap+WILLNEED";
-    m.duration_us = duration;
-    m.file_size = content.size();
-    m.throughput_mbps = (content.size() / 1024.0 / 1024.0) / (duration / 1000000.0);
-    all_metrics.push_back(m);
-    
-    return content;
+    res.set_header("Content-Type", "application/octet-stream");
+    res.set_body_view(mapping->data, mapping->size, mapping);
+    res.on_sent([method, start](size_t bytes_sent){
+        record_sent_metrics(method, start, bytes_sent);
+    });
+    res.end();
 }
 
-// 4. Buffered read with larger buffer
-std::string read_file_buffered(const std::string& filepath) {
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    int fd = open(filepath.c_str(), O_RDONLY);
-    if (fd < 0) return "";
-    
-    struct stat sb;
-    if (fstat(fd, &sb) < 0) {
-        close(fd);
-        return "";
+// Stream a body source out, timed until the last byte was sent. 503 when
+// the source couldn't be set up (e.g. every I/O buffer is in use)
+template <typename Source>
+void send_source(crow::response& res, const char* method,
+                 std::chrono::high_resolution_clock::time_point start,
+                 std::shared_ptr<Source> source) {
+    if (!source) {
+        res.code = 503;
+        res.end();
+        return;
     }
-    
-    std::string content;
-    content.resize(sb.st_size);
-    
-    const size_t BUFFER_SIZE = 1024 * 1024; // 1MB buffer
+    res.set_header("Content-Type", "application/octet-stream");
+    res.set_body_source(source, source->size());
+    res.on_sent([method, start](size_t bytes_sent){
+        record_sent_metrics(method, start, bytes_sent);
+    });
+    res.end();
+}
+
+// Read one segment into its own buffer so it can be kept in the cache, after
+// the header it has to be sent with if any. The file is read through the
+// descriptor crow keeps open for static serving
+SegmentCache::Segment read_segment(const std::string& filepath, uint64_t offset, size_t length,
+                                   const std::string* header = nullptr) {
+    auto file = crow::open_file_cache::instance().get(filepath);
+    if (!file) return nullptr;
+    
+    size_t header_size = header ? header->size() : 0;
+    auto segment = std::make_shared<std::string>(header_size + length, '\0');
+    if (header) segment->replace(0, header_size, *header);
+    char* data = &(*segment)[header_size];
     size_t total_read = 0;
-    
-    while (total_read < sb.st_size) {
-        ssize_t bytes_read = read(fd, &content[total_read], 
-                                  std::min(BUFFER_SIZE, sb.st_size - total_read));
+    while (total_read < length) {
+        ssize_t bytes_read = pread(file->fd, data + total_read, length - total_read, offset + total_read);
         if (bytes_read <= 0) break;
         total_read += bytes_read;
     }
     
-    close(fd);
-    content.resize(total_read);
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    long long duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    
-    Metrics m;
-    m.method = "Buffered 1MB";
-    m.duration_us = duration;
-    m.file_size = content.size();
-    m.throughput_mbps = (content.size() / 1024.0 / 1024.0) / (duration / 1000000.0);
-    all_metrics.push_back(m);
-    
-    return content;
+    if (total_read != length) return nullptr;
+    return segment;
 }
 
-// 5. Direct I/O (O_DIRECT) - bypass page cache
-std::string read_file_direct(const std::string& filepath) {
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    int fd = open(filepath.c_str(), O_RDONLY | O_DIRECT);
-    if (fd < 0) {
-        // O_DIRECT might fail, fallback to regular
-        fd = open(filepath.c_str(), O_RDONLY);
-        if (fd < 0) return "";
+// Warm a segment before it is asked for: into the DRAM cache when the
+// admission policy would take it, otherwise into the page cache so that the
+// sendfile on the miss doesn't wait for the SSD
+void prefetch_segment(SegmentCache& cache, const HlsIndex::Segment& segment) {
+    if (cache.contains(segment.path, segment.offset)) return;
+    size_t header_size = segment.header ? segment.header->size() : 0;
+    if (cache.would_admit(segment.path, segment.offset, header_size + segment.length)) {
+        auto data = read_segment(segment.path, segment.offset, segment.length, segment.header.get());
+        if (data) cache.put(segment.path, segment.offset, data);
+        return;
     }
-    
-    struct stat sb;
-    if (fstat(fd, &sb) < 0) {
-        close(fd);
-        return "";
+    auto file = crow::open_file_cache::instance().get(segment.path);
+    if (file) posix_fadvise(file->fd, segment.offset, segment.length, POSIX_FADV_WILLNEED);
+}
+
+// Next segments of every HLS session, fetched on a background thread per
+// node that runs on the node's CPUs and fills the node's cache
+std::vector<std::unique_ptr<SegmentPrefetcher>> make_prefetchers() {
+    std::vector<std::unique_ptr<SegmentPrefetcher>> prefetchers;
+    for (int node = 0; node < (int)segment_caches.size(); node++) {
+        prefetchers.emplace_back(new SegmentPrefetcher(hls_index, [node](const HlsIndex::Segment& segment) {
+            thread_local bool pinned = crow::cpu_topology::instance().pin_to_node(node);
+            (void)pinned;
+            prefetch_segment(*segment_caches[node], segment);
+        }));
     }
-    
-    // O_DIRECT requires aligned buffers
-    const size_t ALIGNMENT = 4096;
-    const size_t aligned_size = ((sb.st_size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
-    
-    void* buffer;
-    if (posix_memalign(&buffer, ALIGNMENT, aligned_size) != 0) {
-        close(fd);
-        return "";
+    return prefetchers;
+}
+std::vector<std::unique_ptr<SegmentPrefetcher>> hls_prefetchers = make_prefetchers();
+
+// Tells apart the players the prefetcher keeps a window for. AVPlayer and
+// others send X-Playback-Session-Id; without it the client address alone
+// would merge every player behind one NAT, the User-Agent splits most of them
+std::string playback_session(const crow::request& req) {
+    std::string_view id = req.get_header_view("X-Playback-Session-Id");
+    if (!id.empty()) return std::string(id);
+    return req.remote_ip_address + ' ' + std::string(req.get_header_view("User-Agent"));
+}
+
+// Send one segment of a file: straight from the DRAM cache on a hit, read
+// into it when the admission policy wants it, otherwise a sendfile of the
+// range without the data ever entering userspace. A segment that has to be
+// sent after a header is read into memory on a miss instead
+void send_segment(crow::response& res, const std::string& filepath, uint64_t offset,
+                  size_t length, const char* content_type,
+                  std::chrono::high_resolution_clock::time_point start,
+                  const std::string* header = nullptr) {
+    const char* method = "cache hit";
+    SegmentCache& cache = local_segment_cache();
+    size_t header_size = header ? header->size() : 0;
+    auto cached = cache.get(filepath, offset);
+    if (!cached && cache.would_admit(filepath, offset, header_size + length)) {
+        method = "cache fill";
+        cached = read_segment(filepath, offset, length, header);
+        if (cached) cache.put(filepath, offset, cached);
+    } else if (!cached && header) {
+        method = "cache miss/read";
+        cached = read_segment(filepath, offset, length, header);
+        if (!cached) {
+            res.code = 404;
+            res.end();
+            return;
+        }
     }
     
-    ssize_t bytes_read = read(fd, buffer, aligned_size);
-    
-    std::string content;
-    if (bytes_read > 0) {
-        content.assign(static_cast<char*>(buffer), std::min((size_t)bytes_read, (size_t)sb.st_size));
+    if (cached) {
+        // Served straight from the cached buffer, which stays pinned until sent
+        res.set_header("Content-Type", content_type);
+        res.set_body_view(cached->data(), cached->size(), cached);
+    } else {
+        method = "cache miss/sendfile";
+        res.set_static_file_info_unsafe(filepath, content_type);
+        res.set_static_file_extent(offset, length);
     }
-    
-    free(buffer);
-    close(fd);
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    long long duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    
-    Metrics m;
-    m.method = "Direct I/O";
-    m.duration_us = duration;
-    m.file_size = content.size();
-    m.throughput_mbps = (content.size() / 1024.0 / 1024.0) / (duration / 1000000.0);
-    all_metrics.push_back(m);
-    
-    return content;
+    res.on_sent([start, method](size_t bytes_sent){
+        record_sent_metrics(method, start, bytes_sent);
+    });
+    res.end();
+}
+
+// Playlists are kept in memory by the index, send them without a copy
+void send_playlist(crow::response& res, HlsIndex::Playlist playlist) {
+    if (!playlist) {
+        res.code = 404;
+        res.end();
+        return;
+    }
+    res.set_header("Content-Type", "application/vnd.apple.mpegurl");
+    res.set_body_view(playlist->data(), playlist->size(), playlist);
+    res.end();
+}
+
+// 9. io_uring - batched O_DIRECT reads into registered buffers. One ring per
+// worker thread, completions come back through that thread's io_context, so
+// the worker keeps serving other connections while the SSD works
+UringReader* uring_for(asio::io_context& io_context) {
+    thread_local std::unique_ptr<UringReader> ring;
+    if (!ring) ring.reset(new UringReader(io_context, local_slab_pool()));
+    return ring->ok() ? ring.get() : nullptr;
 }
 
 // Helper function to create test file
@@ -229,18 +347,117 @@ void create_test_file(const std::string& filename, size_t size_mb) {
     std::cout << "Created test file: " << filename << " (" << size_mb << " MB)\n";
 }
 
+// Move everything recorded so far into the summary and the console backlog
+void collect_metrics() {
+    std::lock_guard<std::mutex> lock(console_mutex);
+    metrics.drain([](const Metrics& m) {
+        metrics_summary.add(m);
+        console_samples.push_back(m);
+    });
+}
+
+// Fraction of a file's pages that are in the page cache, -1 if it can't be mapped
+double page_cache_residency(const std::string& filepath) {
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) return -1;
+    
+    struct stat sb;
+    if (fstat(fd, &sb) < 0 || sb.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    
+    // Mapping without touching it faults nothing in, mincore only reports
+    void* mapped = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return -1;
+    
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t pages = (sb.st_size + page_size - 1) / page_size;
+    std::vector<unsigned char> resident(pages);
+    size_t resident_pages = 0;
+    if (mincore(mapped, sb.st_size, resident.data()) == 0) {
+        for (unsigned char page : resident) resident_pages += page & 1;
+    }
+    munmap(mapped, sb.st_size);
+    
+    return (double)resident_pages / pages;
+}
+
+// Prometheus text format: per-method counters and histograms, the segment
+// cache counters and how much of the test file sits in the page cache
+std::string render_metrics(const std::string& filepath) {
+    collect_metrics();
+    
+    std::string out;
+    metrics_summary.write_prometheus(out);
+    
+    auto counter = [&out](const char* name, const char* help, uint64_t value) {
+        out += std::string("# HELP ") + name + " " + help + "\n";
+        out += std::string("# TYPE ") + name + " counter\n";
+        out += std::string(name) + " " + std::to_string(value) + "\n";
+    };
+    counter("zc_metrics_dropped_total", "Samples lost to full per-thread rings.", metrics.dropped());
+    counter("zc_prefetch_queued_total", "HLS segments queued for prefetching.",
+            node_total(hls_prefetchers, [](SegmentPrefetcher& p) { return p.queued(); }));
+    counter("zc_prefetch_dropped_total", "HLS prefetches dropped on a full queue.",
+            node_total(hls_prefetchers, [](SegmentPrefetcher& p) { return p.dropped(); }));
+    counter("zc_mapping_cache_hits_total", "Lookups that found a current mapping.", mapping_cache.hits());
+    counter("zc_mapping_cache_misses_total", "Lookups that had to map the file.", mapping_cache.misses());
+    counter("zc_mapping_cache_evictions_total", "Mappings dropped for address space.", mapping_cache.evictions());
+    counter("zc_segment_cache_hits_total", "Segment cache lookups that hit.",
+            node_total(segment_caches, [](SegmentCache& c) { return c.hits(); }));
+    counter("zc_segment_cache_misses_total", "Segment cache lookups that missed.",
+            node_total(segment_caches, [](SegmentCache& c) { return c.misses(); }));
+    counter("zc_segment_cache_evictions_total", "Segments evicted to make room.",
+            node_total(segment_caches, [](SegmentCache& c) { return c.evictions(); }));
+    counter("zc_segment_cache_rejections_total", "Segments refused by the admission policy.",
+            node_total(segment_caches, [](SegmentCache& c) { return c.rejections(); }));
+    
+    out += "# HELP zc_mapping_cache_bytes Bytes of files kept mapped.\n";
+    out += "# TYPE zc_mapping_cache_bytes gauge\n";
+    out += "zc_mapping_cache_bytes " + std::to_string(mapping_cache.mapped_bytes()) + "\n";
+    out += "# HELP zc_segment_cache_bytes Bytes held by the segment cache, by NUMA node.\n";
+    out += "# TYPE zc_segment_cache_bytes gauge\n";
+    for (size_t node = 0; node < segment_caches.size(); node++) {
+        out += "zc_segment_cache_bytes{node=\"" + std::to_string(node) + "\"} " +
+               std::to_string(segment_caches[node]->size_bytes()) + "\n";
+    }
+    
+    double residency = page_cache_residency(filepath);
+    if (residency >= 0) {
+        char value[32];
+        snprintf(value, sizeof(value), "%.4f", residency);
+        out += "# HELP zc_page_cache_residency_ratio Fraction of the test file in the page cache.\n";
+        out += "# TYPE zc_page_cache_residency_ratio gauge\n";
+        out += "zc_page_cache_residency_ratio{file=\"" + filepath + "\"} " + value + "\n";
+    }
+    return out;
+}
+
 // Print metrics
 void print_metrics() {
+    collect_metrics();
+    std::vector<Metrics> samples;
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        samples.swap(console_samples);
+    }
+    if (samples.empty()) return;
+
     std::cout << "\n========== PERFORMANCE METRICS ==========\n";
     std::cout << "Method              | Time (ms) | Throughput (MB/s)\n";
     std::cout << "--------------------|-----------|-----------------\n";
     
-    for (const auto& m : all_metrics) {
+    for (const auto& m : samples) {
         printf("%-19s | %9.2f | %15.2f\n", 
-               m.method.c_str(), 
+               m.method, 
                m.duration_us / 1000.0, 
                m.throughput_mbps);
     }
+    if (metrics.dropped() > 0) {
+        std::cout << "(" << metrics.dropped() << " samples dropped so far)\n";
+    }
     std::cout << "=========================================\n\n";
 }
 
@@ -258,53 +475,135 @@ int main() {
     
     // Route 1: Traditional copy
     CROW_ROUTE(app, "/traditional")
-    ([&test_file](){
-        auto content = read_file_traditional(test_file);
-        auto resp = crow::response(content);
-        resp.set_header("Content-Type", "application/octet-stream");
-        return resp;
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        res.body = read_file_traditional(test_file);
+        res.set_header("Content-Type", "application/octet-stream");
+        res.on_sent([start](size_t bytes_sent){
+            record_sent_metrics("Traditional Copy", start, bytes_sent);
+        });
+        res.end();
     });
     
-    // Route 2: mmap
+    // Route 2: mmap, sent from the cached mapping
     CROW_ROUTE(app, "/mmap")
-    ([&test_file](){
-        auto content = read_file_mmap(test_file);
-        auto resp = crow::response(content);
-        resp.set_header("Content-Type", "application/octet-stream");
-        return resp;
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        send_mapping(res, "mmap", start, mapping_cache.get(test_file), false);
     });
     
-    // Route 3: mmap with WILLNEED
+    // Route 3: mmap with WILLNEED, sent from the cached mapping
     CROW_ROUTE(app, "/mmap-willneed")
-    ([&test_file](){
-        auto content = read_file_mmap_willneed(test_file);
-        auto resp = crow::response(content);
-        resp.set_header("Content-Type", "application/octet-stream");
-        return resp;
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        send_mapping(res, "mmap+WILLNEED", start, mapping_cache.get(test_file), true);
     });
     
-    // Route 4: Buffered read
+    // Route 4: Buffered read, streamed
     CROW_ROUTE(app, "/buffered")
-    ([&test_file](){
-        auto content = read_file_buffered(test_file);
-        auto resp = crow::response(content);
-        resp.set_header("Content-Type", "application/octet-stream");
-        return resp;
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        send_source(res, "Buffered 1MB", start, ReadFileSource::open(test_file, false));
     });
     
-    // Route 5: Direct I/O
+    // Route 5: Direct I/O, streamed
     CROW_ROUTE(app, "/direct")
-    ([&test_file](){
-        auto content = read_file_direct(test_file);
-        auto resp = crow::response(content);
-        resp.set_header("Content-Type", "application/octet-stream");
-        return resp;
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        send_source(res, "Direct I/O", start, ReadFileSource::open(test_file, true));
+    });
+    
+    // Route 6: sendfile (zero-copy)
+    CROW_ROUTE(app, "/sendfile")
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        res.set_static_file_info_unsafe(test_file, "application/octet-stream");
+        res.set_static_file_transfer(crow::response::file_transfer::sendfile);
+        res.on_sent([start](size_t bytes_sent){
+            record_sent_metrics("sendfile", start, bytes_sent);
+        });
+        res.end();
+    });
+    
+    // Route 7: splice file -> pipe -> socket (zero-copy)
+    CROW_ROUTE(app, "/splice")
+    ([&test_file](crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        res.set_static_file_info_unsafe(test_file, "application/octet-stream");
+        res.set_static_file_transfer(crow::response::file_transfer::splice);
+        res.on_sent([start](size_t bytes_sent){
+            record_sent_metrics("splice", start, bytes_sent);
+        });
+        res.end();
+    });
+    
+    // Route 8: segment through the DRAM cache, misses fall through to sendfile
+    CROW_ROUTE(app, "/segment/<uint>")
+    ([&test_file](crow::response& res, uint64_t segment){
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        auto file = crow::open_file_cache::instance().get(test_file);
+        uint64_t offset = segment * SEGMENT_SIZE;
+        if (!file || offset >= (uint64_t)file->statbuf.st_size) {
+            res.code = 404;
+            res.end();
+            return;
+        }
+        size_t length = std::min<uint64_t>(SEGMENT_SIZE, file->statbuf.st_size - offset);
+        send_segment(res, test_file, offset, length, "video/mp2t", start);
+    });
+    
+    // Route 9: io_uring, streamed with reads running ahead of the socket
+    CROW_ROUTE(app, "/uring")
+    ([&test_file](const crow::request& req, crow::response& res){
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        UringReader* ring = uring_for(*req.io_context);
+        auto source = ring ? UringFileSource::open(*ring, test_file) : nullptr;
+        if (!source) {
+            // No io_uring on this kernel, serve it the blocking O_DIRECT way
+            send_source(res, "Direct I/O", start, ReadFileSource::open(test_file, true));
+            return;
+        }
+        send_source(res, "io_uring", start, source);
+    });
+    
+    // Route 10: HLS master playlist over the renditions in media/
+    CROW_ROUTE(app, "/hls/master.m3u8")
+    ([](crow::response& res){
+        send_playlist(res, hls_index.master_playlist());
+    });
+    
+    // Route 11: HLS media playlist or segment of one rendition
+    CROW_ROUTE(app, "/hls/<string>/<string>")
+    ([](const crow::request& req, crow::response& res,
+        const std::string& rendition, const std::string& file){
+        auto start = std::chrono::high_resolution_clock::now();
+        if (file == "index.m3u8") {
+            send_playlist(res, hls_index.media_playlist(rendition));
+            return;
+        }
+        
+        char* end = nullptr;
+        unsigned long index = strtoul(file.c_str(), &end, 10);
+        HlsIndex::Segment segment;
+        if (end == file.c_str() || strcmp(end, ".ts") != 0 ||
+            !hls_index.segment(rendition, index, segment)) {
+            res.code = 404;
+            res.end();
+            return;
+        }
+        hls_prefetchers[crow::cpu_topology::instance().current_node()]->played(playback_session(req), rendition, index);
+        send_segment(res, segment.path, segment.offset, segment.length, "video/mp2t", start,
+                     segment.header.get());
     });
     
-    // Metrics endpoint
+    // Metrics endpoint, Prometheus text format
     CROW_ROUTE(app, "/metrics")
-    ([](){
-        return "Check console for metrics";
+    ([&test_file](){
+        auto resp = crow::response(render_metrics(test_file));
+        resp.set_header("Content-Type", "text/plain; version=0.0.4");
+        return resp;
     });
     
     // Info endpoint
@@ -315,15 +614,22 @@ Zero-Copy File Server Test Suite
 =================================
 
 Available endpoints:
-- /traditional     : Standard ifstream read
-- /mmap           : Memory-mapped file
-- /mmap-willneed  : mmap with prefetch hint
-- /buffered       : Buffered read (1MB chunks)
-- /direct         : Direct I/O (O_DIRECT)
+- /traditional     : Standard ifstream read (timed until sent)
+- /mmap           : Memory-mapped file, kept mapped (timed until sent)
+- /mmap-willneed  : mmap with prefetch hint, kept mapped (timed until sent)
+- /buffered       : Buffered read (1MB chunks), streamed (timed until sent)
+- /direct         : Direct I/O (O_DIRECT), streamed (timed until sent)
+- /sendfile       : sendfile(2), zero-copy (timed until sent)
+- /splice         : splice(2) file -> pipe -> socket (timed until sent)
+- /segment/<n>    : 4MB segment n via the DRAM cache, sendfile on a miss
+- /uring          : io_uring O_DIRECT reads ahead of the socket (timed until sent)
+- /hls/master.m3u8: HLS master playlist over the .ts files in media/
+- /hls/<name>/index.m3u8, /hls/<name>/<n>.ts : media playlist and segments
+- /metrics        : Prometheus-format counters, histograms and cache gauges
 
 Test with: curl http://localhost:18080/<endpoint> -o /dev/null
 
-Then check console for performance metrics.
+Then check console or /metrics for performance metrics.
         )";
     });
     
@@ -335,15 +641,12 @@ Then check console for performance metrics.
     std::thread metrics_thread([]{
         while (true) {
             std::this_thread::sleep_for(std::chrono::seconds(5));
-            if (!all_metrics.empty()) {
-                print_metrics();
-                all_metrics.clear();
-            }
+            print_metrics();
         }
     });
     metrics_thread.detach();
     
-    app.port(18080).multithreaded().run();
+    app.port(18080).multithreaded().reuse_port(true).pin_workers().use_request_views().run();
     
     return 0;
 }
\ No newline at end of file